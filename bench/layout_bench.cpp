@@ -0,0 +1,215 @@
+// Block layout benchmark, linear (x + y*16 + z*256) vs morton order inside a chunk
+// usage: layout_bench [chunk count] [repeats]
+//
+// the game picks one layout at compile time (BLOCK_LAYOUT in config.h), this runs both side by side
+// on the same terrain, stored packed (BlockStorage, what chunks use) and as a flat BlockData array (what the mesher copies into)
+// workloads walk the chunks in random order so the whole set doesn't just sit in cache
+
+#include "block_storage.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <numeric>
+#include <random>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+typedef int (*IndexFunction)(int x, int y, int z);
+
+class FlatBlocks {
+public:
+    FlatBlocks() : blocks(CHUNK_VOLUME) {}
+    BlockData get(int index) const { return blocks[index]; }
+    void set(int index, const BlockData& block) { blocks[index] = block; }
+    void pack(const BlockData* data) { std::copy(data, data + CHUNK_VOLUME, blocks.begin()); }
+
+private:
+    std::vector<BlockData> blocks;
+};
+
+// hills of grass/dirt over stone with a few ores, the part above the surface is air
+static void synthesizeTerrain(std::vector<BlockData>& blocks, IndexFunction index, int chunk, std::mt19937& rng) {
+    blocks.assign(CHUNK_VOLUME, BlockData());
+    int baseHeight = chunk % 3 == 0 ? CHUNK_SIZE : 4 + chunk % 9;
+
+    for (int z = 0; z < CHUNK_SIZE; z++) {
+        for (int x = 0; x < CHUNK_SIZE; x++) {
+            int height = std::min(CHUNK_SIZE, baseHeight + static_cast<int>(3 * std::sin(x * 0.4 + chunk) + 2 * std::cos(z * 0.3)));
+            for (int y = 0; y < height; y++) {
+                BlockData& block = blocks[index(x, y, z)];
+                if (y == height - 1) block.id = 2;
+                else if (y > height - 4) block.id = 3;
+                else block.id = rng() % 40 == 0 ? 14 + rng() % 4 : 1;
+            }
+        }
+    }
+}
+
+template <typename Store, IndexFunction Index>
+struct Workloads {
+    static uint64_t rows(const Store& blocks) {
+        uint64_t sum = 0;
+        for (int z = 0; z < CHUNK_SIZE; z++)
+            for (int y = 0; y < CHUNK_SIZE; y++)
+                for (int x = 0; x < CHUNK_SIZE; x++)
+                    sum += blocks.get(Index(x, y, z)).id;
+        return sum;
+    }
+
+    // visible face count, like the mesher and occlusion tests
+    static uint64_t neighbors(const Store& blocks) {
+        static const int offsets[6][3] = {{1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1}};
+        uint64_t faces = 0;
+        for (int z = 1; z < CHUNK_SIZE - 1; z++)
+            for (int y = 1; y < CHUNK_SIZE - 1; y++)
+                for (int x = 1; x < CHUNK_SIZE - 1; x++) {
+                    if (blocks.get(Index(x, y, z)).id == 0) continue;
+                    for (const auto& offset : offsets) {
+                        faces += blocks.get(Index(x + offset[0], y + offset[1], z + offset[2])).id == 0;
+                    }
+                }
+        return faces;
+    }
+
+    // voxel DDA from random points in random directions until the ray hits a block or leaves the chunk
+    static uint64_t rays(const Store& blocks, std::mt19937& rng) {
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+        std::uniform_real_distribution<float> inside(0.0f, static_cast<float>(CHUNK_SIZE));
+        uint64_t steps = 0;
+
+        for (int ray = 0; ray < 64; ray++) {
+            float origin[3] = {inside(rng), inside(rng), inside(rng)};
+            float direction[3] = {unit(rng), unit(rng), unit(rng)};
+            int cell[3], step[3];
+            float tMax[3], tDelta[3];
+            for (int axis = 0; axis < 3; axis++) {
+                cell[axis] = static_cast<int>(origin[axis]);
+                step[axis] = direction[axis] >= 0 ? 1 : -1;
+                float absDirection = std::max(std::fabs(direction[axis]), 1e-6f);
+                tDelta[axis] = 1.0f / absDirection;
+                float boundary = step[axis] > 0 ? cell[axis] + 1 - origin[axis] : origin[axis] - cell[axis];
+                tMax[axis] = boundary / absDirection;
+            }
+
+            while (cell[0] >= 0 && cell[0] < CHUNK_SIZE && cell[1] >= 0 && cell[1] < CHUNK_SIZE && cell[2] >= 0 && cell[2] < CHUNK_SIZE) {
+                steps++;
+                if (blocks.get(Index(cell[0], cell[1], cell[2])).id != 0) break;
+                int axis = tMax[0] < tMax[1] ? (tMax[0] < tMax[2] ? 0 : 2) : (tMax[1] < tMax[2] ? 1 : 2);
+                cell[axis] += step[axis];
+                tMax[axis] += tDelta[axis];
+            }
+        }
+        return steps;
+    }
+
+    // 2x LOD, a cell is solid when most of its 8 blocks are
+    static uint64_t downsample(const Store& blocks) {
+        uint64_t solid = 0;
+        for (int z = 0; z < CHUNK_SIZE; z += 2)
+            for (int y = 0; y < CHUNK_SIZE; y += 2)
+                for (int x = 0; x < CHUNK_SIZE; x += 2) {
+                    int count = 0;
+                    for (int i = 0; i < 8; i++) {
+                        count += blocks.get(Index(x + (i & 1), y + ((i >> 1) & 1), z + (i >> 2))).id != 0;
+                    }
+                    solid += count >= 4;
+                }
+        return solid;
+    }
+
+    // spheres of air like the cave generator
+    static uint64_t carve(Store& blocks, std::mt19937& rng) {
+        uint64_t carved = 0;
+        for (int cave = 0; cave < 4; cave++) {
+            int center[3] = {static_cast<int>(rng() % CHUNK_SIZE), static_cast<int>(rng() % CHUNK_SIZE), static_cast<int>(rng() % CHUNK_SIZE)};
+            int radius = 2 + rng() % 3;
+            for (int z = std::max(0, center[2] - radius); z <= std::min(CHUNK_SIZE - 1, center[2] + radius); z++)
+                for (int y = std::max(0, center[1] - radius); y <= std::min(CHUNK_SIZE - 1, center[1] + radius); y++)
+                    for (int x = std::max(0, center[0] - radius); x <= std::min(CHUNK_SIZE - 1, center[0] + radius); x++) {
+                        int dx = x - center[0], dy = y - center[1], dz = z - center[2];
+                        if (dx * dx + dy * dy + dz * dz > radius * radius) continue;
+                        int index = Index(x, y, z);
+                        if (blocks.get(index).id == 0) continue;
+                        blocks.set(index, BlockData());
+                        carved++;
+                    }
+        }
+        return carved;
+    }
+};
+
+static const char* WORKLOAD_NAMES[] = {"rows", "neighbors", "rays", "downsample", "carve"};
+static constexpr int WORKLOAD_COUNT = 5;
+
+// ns per chunk for every workload, best of the repeats
+template <typename Store, IndexFunction Index>
+static void measure(int chunkCount, int repeats, double (&result)[WORKLOAD_COUNT], uint64_t& checksum) {
+    std::mt19937 rng(1234);
+    std::vector<Store> chunks(chunkCount);
+    std::vector<BlockData> blocks;
+    for (int i = 0; i < chunkCount; i++) {
+        synthesizeTerrain(blocks, Index, i, rng);
+        chunks[i].pack(blocks.data());
+    }
+
+    std::vector<int> order(chunkCount);
+    std::iota(order.begin(), order.end(), 0);
+    std::shuffle(order.begin(), order.end(), rng);
+
+    typedef Workloads<Store, Index> W;
+    for (int workload = 0; workload < WORKLOAD_COUNT; workload++) {
+        double best = 1e30;
+        for (int repeat = 0; repeat < repeats; repeat++) {
+            // carve edits the chunks, every repeat starts from the same terrain
+            std::vector<Store> copies;
+            if (workload == 4) copies = chunks;
+
+            std::mt19937 workloadRng(42);
+            auto start = Clock::now();
+            for (int i : order) {
+                switch (workload) {
+                    case 0: checksum += W::rows(chunks[i]); break;
+                    case 1: checksum += W::neighbors(chunks[i]); break;
+                    case 2: checksum += W::rays(chunks[i], workloadRng); break;
+                    case 3: checksum += W::downsample(chunks[i]); break;
+                    case 4: checksum += W::carve(copies[i], workloadRng); break;
+                }
+            }
+            double elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / chunkCount;
+            best = std::min(best, elapsed);
+        }
+        result[workload] = best;
+    }
+}
+
+template <typename Store>
+static void compare(const char* storeName, int chunkCount, int repeats) {
+    double linear[WORKLOAD_COUNT], morton[WORKLOAD_COUNT];
+    uint64_t linearChecksum = 0, mortonChecksum = 0;
+    measure<Store, linearBlockIndex>(chunkCount, repeats, linear, linearChecksum);
+    measure<Store, mortonBlockIndex>(chunkCount, repeats, morton, mortonChecksum);
+
+    // same terrain and the same random rays/caves, so both layouts have to come up with the same results
+    for (int workload = 0; workload < WORKLOAD_COUNT; workload++) {
+        const char* winner = linear[workload] <= morton[workload] ? "linear" : "morton";
+        std::printf("%-8s %-12s %14.0f %14.0f %8.2fx  %s\n", storeName, WORKLOAD_NAMES[workload], linear[workload], morton[workload], linear[workload] / morton[workload], winner);
+    }
+    if (linearChecksum != mortonChecksum) {
+        std::printf("checksums differ: %llu vs %llu\n", static_cast<unsigned long long>(linearChecksum), static_cast<unsigned long long>(mortonChecksum));
+    }
+}
+
+int main(int argc, char** argv) {
+    int chunkCount = argc > 1 ? std::atoi(argv[1]) : 2048;
+    int repeats = argc > 2 ? std::atoi(argv[2]) : 5;
+
+    std::printf("%d chunks, best of %d, compiled with the %s layout\n", chunkCount, repeats, BLOCK_LAYOUT == BlockLayout::Morton ? "morton" : "linear");
+    std::printf("%-8s %-12s %14s %14s %9s  %s\n", "store", "workload", "linear ns/ch", "morton ns/ch", "speedup", "winner");
+
+    compare<BlockStorage>("packed", chunkCount, repeats);
+    compare<FlatBlocks>("flat", chunkCount, repeats);
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,97 @@
+// Chunk meshing benchmark, per face vs greedy vs binary mesher (and the LOD meshes) on the same padded chunks
+// usage: mesh_bench [chunk count] [repeats]
+//
+// only the mesher runs, the padded copy is made up front like a mesh job does under its epoch guard
+// terrain is surface chunks (hills, grass over dirt over stone, some ores) and cave chunks (stone with air pockets)
+
+#include "mesh_system.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+// border included, so faces toward the neighbors are culled like in the game
+static void synthesizeChunk(PaddedChunk& chunk, int index, std::mt19937& rng) {
+    bool cave = index % 4 == 3;
+    int baseHeight = 4 + index % 9;
+
+    for (int z = -1; z <= CHUNK_SIZE; z++) {
+        for (int x = -1; x <= CHUNK_SIZE; x++) {
+            int height = cave ? CHUNK_SIZE + 1 : baseHeight + static_cast<int>(3 * std::sin(x * 0.4 + index) + 2 * std::cos(z * 0.3));
+            for (int y = -1; y <= CHUNK_SIZE; y++) {
+                BlockData& block = chunk.blocks[getPaddedIndex(x, y, z)];
+                block = BlockData();
+                if (y >= height) continue;
+
+                if (cave) {
+                    int dx = x - 8, dy = y - 8, dz = z - 8;
+                    if (dx * dx + dy * dy * 2 + dz * dz < 30 || rng() % 12 == 0) continue;
+                    block.id = rng() % 30 == 0 ? 13 + rng() % 4 : 12;
+                } else if (y == height - 1) {
+                    block.id = 2;
+                } else if (y > height - 4) {
+                    block.id = 1;
+                } else {
+                    block.id = rng() % 40 == 0 ? 8 + rng() % 4 : 4;
+                }
+            }
+        }
+    }
+}
+
+struct Mesher {
+    const char* name;
+    MeshingMode mode;
+    int lod;
+};
+
+int main(int argc, char** argv) {
+    int chunkCount = argc > 1 ? std::atoi(argv[1]) : 256;
+    int repeats = argc > 2 ? std::atoi(argv[2]) : 5;
+
+    std::mt19937 rng(1234);
+    std::vector<std::unique_ptr<PaddedChunk>> chunks;
+    for (int i = 0; i < chunkCount; i++) {
+        chunks.push_back(std::make_unique<PaddedChunk>());
+        synthesizeChunk(*chunks.back(), i, rng);
+    }
+
+    const Mesher meshers[] = {
+        {"per face", MeshingMode::PerFace, 1},
+        {"greedy", MeshingMode::Greedy, 1},
+        {"binary", MeshingMode::Binary, 1},
+        {"binary lod2", MeshingMode::Binary, 2},
+        {"binary lod4", MeshingMode::Binary, 4},
+    };
+
+    std::printf("%d chunks, best of %d\n", chunkCount, repeats);
+    std::printf("%-12s %12s %12s %12s\n", "mesher", "us/chunk", "quads/chunk", "KB/chunk");
+
+    MeshSystem meshSystem;
+    for (const Mesher& mesher : meshers) {
+        meshSystem.meshingMode = mesher.mode;
+
+        double best = 1e30;
+        size_t quads = 0;
+        for (int repeat = 0; repeat < repeats; repeat++) {
+            quads = 0;
+            auto start = Clock::now();
+            for (const auto& chunk : chunks) {
+                ChunkMeshData data = meshSystem.createChunkData(*chunk, mesher.lod);
+                quads += data.vertices.size() / 4;
+            }
+            double elapsed = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / chunkCount;
+            best = std::min(best, elapsed);
+        }
+
+        double quadsPerChunk = static_cast<double>(quads) / chunkCount;
+        std::printf("%-12s %12.1f %12.0f %12.1f\n", mesher.name, best, quadsPerChunk, quadsPerChunk * 4 * sizeof(ChunkVertex) / 1024.0);
+    }
+    return 0;
+}
@@ -0,0 +1,270 @@
+// Chunk storage benchmark, runs without a window or GL context
+// usage: storage_bench [chunk count] [edit density ...]
+// density is the fraction of a chunk's blocks the player changed, default 0.01 0.1 0.5
+//
+// every backend gets the same synthesized chunks and is measured on:
+// write throughput, cold reads (fresh backend instance), warm reads (same instance again), files and bytes on disk
+// cold only means the game's own caches are empty, the OS file cache is still warm
+
+#include "chunk.h"
+#include "region_storage.h"
+#include "chunk_writer.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static const std::string BENCH_FOLDER = "bench_worlds";
+
+// new storage backends plug in here, the workload is the same for all of them
+class StorageBackend {
+public:
+    virtual ~StorageBackend() = default;
+    virtual void write(Chunk& chunk) = 0;
+    virtual bool read(Chunk& chunk) = 0;
+    virtual void flush() = 0; // everything written is on disk after this
+};
+
+// the original format, one file per chunk: size_t count | (uint64 hashChunkCoords key, id, rotation) per block
+class LegacyFileBackend : public StorageBackend {
+public:
+    LegacyFileBackend(const std::string& folder) : folder(folder) {
+        std::filesystem::create_directories(folder);
+    }
+
+    void write(Chunk& chunk) override {
+        std::ofstream outputFile(path(chunk), std::ios::out | std::ios::binary);
+        if (!outputFile.is_open()) return;
+
+        size_t numBlocks = chunk.modifiedBlocks.size();
+        outputFile.write(reinterpret_cast<const char*>(&numBlocks), sizeof(numBlocks));
+
+        for (const BlockDelta::Entry& entry : chunk.modifiedBlocks.getEntries()) {
+            int x = entry.index % CHUNK_SIZE;
+            int y = (entry.index / CHUNK_SIZE) % CHUNK_SIZE;
+            int z = entry.index / (CHUNK_SIZE * CHUNK_SIZE);
+            uint64_t key = hashChunkCoords(x, y, z);
+
+            outputFile.write(reinterpret_cast<const char*>(&key), sizeof(key));
+            outputFile.write(reinterpret_cast<const char*>(&entry.data.id), sizeof(entry.data.id));
+            outputFile.write(reinterpret_cast<const char*>(&entry.data.rotation), sizeof(entry.data.rotation));
+        }
+    }
+
+    bool read(Chunk& chunk) override {
+        std::ifstream inputFile(path(chunk), std::ios::in | std::ios::binary);
+        if (!inputFile.is_open()) return false;
+
+        size_t numBlocks = 0;
+        inputFile.read(reinterpret_cast<char*>(&numBlocks), sizeof(numBlocks));
+        if (!inputFile || numBlocks > CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE) return false;
+
+        for (size_t i = 0; i < numBlocks; ++i) {
+            uint64_t key = 0;
+            BlockData data;
+            if (!inputFile.read(reinterpret_cast<char*>(&key), sizeof(key)) ||
+                !inputFile.read(reinterpret_cast<char*>(&data.id), sizeof(data.id)) ||
+                !inputFile.read(reinterpret_cast<char*>(&data.rotation), sizeof(data.rotation))) {
+                return false;
+            }
+
+            int x, y, z;
+            decodeChunkHash(key, x, y, z);
+            chunk.modifiedBlocks.set(x + y * CHUNK_SIZE + z * CHUNK_SIZE * CHUNK_SIZE, data);
+        }
+
+        chunk.modifiedBlocks.applyTo(chunk.blocks);
+        return true;
+    }
+
+    void flush() override {}
+
+private:
+    std::string path(const Chunk& chunk) {
+        return folder + "/" + std::to_string(chunk.position.x / CHUNK_SIZE) + "_" + std::to_string(chunk.position.y / CHUNK_SIZE) + "_" + std::to_string(chunk.position.z / CHUNK_SIZE) + ".chunk";
+    }
+
+    std::string folder;
+};
+
+// region files written directly
+class RegionBackend : public StorageBackend {
+public:
+    RegionBackend(const std::string& folder) : storage(folder) {}
+
+    void write(Chunk& chunk) override { storage.writeChunk(chunk); }
+    bool read(Chunk& chunk) override { return storage.readChunk(chunk) == ReadResult::Found; }
+    void flush() override { storage.sync(); }
+
+private:
+    RegionStorage storage;
+};
+
+// region files through the background writer, what the game does
+class RegionWriterBackend : public StorageBackend {
+public:
+    RegionWriterBackend(const std::string& folder) : storage(folder), writer(storage) {}
+
+    void write(Chunk& chunk) override { writer.save(chunk); }
+    bool read(Chunk& chunk) override { return writer.readPending(chunk) || storage.readChunk(chunk) == ReadResult::Found; }
+    void flush() override { writer.flush(); }
+
+private:
+    RegionStorage storage;
+    ChunkWriter writer;
+};
+
+struct Backend {
+    const char* name;
+    std::unique_ptr<StorageBackend> (*create)(const std::string& folder);
+};
+
+static const Backend BACKENDS[] = {
+    {"legacy files", [](const std::string& folder) -> std::unique_ptr<StorageBackend> { return std::make_unique<LegacyFileBackend>(folder); }},
+    {"region", [](const std::string& folder) -> std::unique_ptr<StorageBackend> { return std::make_unique<RegionBackend>(folder); }},
+    {"region + writer", [](const std::string& folder) -> std::unique_ptr<StorageBackend> { return std::make_unique<RegionWriterBackend>(folder); }},
+};
+
+// edits come in runs like dug tunnels and built walls, not single random blocks
+static void synthesizeChunks(std::vector<std::unique_ptr<Chunk>>& chunks, int count, double density, unsigned seed) {
+    std::mt19937 rng(seed);
+    const int blockCount = CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE;
+    int side = static_cast<int>(std::ceil(std::cbrt(count)));
+
+    chunks.clear();
+    for (int i = 0; i < count; i++) {
+        auto chunk = std::make_unique<Chunk>();
+        chunk->position = glm::vec3(i % side - side / 2, (i / side) % side - side / 2, i / (side * side) - side / 2) * float(CHUNK_SIZE);
+
+        int edits = static_cast<int>(blockCount * density);
+        while (static_cast<int>(chunk->modifiedBlocks.size()) < edits) {
+            int start = rng() % blockCount;
+            int length = 1 + rng() % 16;
+            uint8_t id = rng() % 4 == 0 ? 0 : 1 + rng() % 17;
+
+            for (int index = start; index < std::min(start + length, blockCount); index++) {
+                int x = index % CHUNK_SIZE;
+                int y = (index / CHUNK_SIZE) % CHUNK_SIZE;
+                int z = index / (CHUNK_SIZE * CHUNK_SIZE);
+                changeBlockID(*chunk, x, y, z, id);
+            }
+        }
+
+        chunks.push_back(std::move(chunk));
+    }
+}
+
+static void folderStats(const std::string& folder, size_t& files, uintmax_t& bytes) {
+    files = 0;
+    bytes = 0;
+    for (const auto& file : std::filesystem::recursive_directory_iterator(folder)) {
+        if (!file.is_regular_file()) continue;
+        files++;
+        bytes += file.file_size();
+    }
+}
+
+static double microseconds(Clock::duration duration) {
+    return std::chrono::duration<double, std::micro>(duration).count();
+}
+
+// average and p99 per chunk read in microseconds, false if anything didn't read back right
+static bool measureReads(StorageBackend& backend, const std::vector<std::unique_ptr<Chunk>>& chunks, double& average, double& p99) {
+    std::vector<double> times;
+    times.reserve(chunks.size());
+    bool ok = true;
+
+    auto chunk = std::make_unique<Chunk>();
+    for (const auto& original : chunks) {
+        chunk->position = original->position;
+        chunk->modifiedBlocks.clear();
+
+        auto start = Clock::now();
+        bool found = backend.read(*chunk);
+        times.push_back(microseconds(Clock::now() - start));
+
+        if (!found || chunk->modifiedBlocks.size() != original->modifiedBlocks.size()) ok = false;
+    }
+
+    average = 0;
+    for (double time : times) average += time;
+    average /= times.empty() ? 1 : times.size();
+
+    std::sort(times.begin(), times.end());
+    p99 = times.empty() ? 0 : times[std::min(times.size() - 1, times.size() * 99 / 100)];
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    int chunkCount = argc > 1 ? std::atoi(argv[1]) : 1000;
+    std::vector<double> densities;
+    for (int i = 2; i < argc; i++) {
+        densities.push_back(std::atof(argv[i]));
+    }
+    if (densities.empty()) {
+        densities = {0.01, 0.1, 0.5};
+    }
+
+    std::cout << chunkCount << " chunks" << std::endl;
+    std::printf("%-16s %8s %12s %10s %14s %14s %7s %11s\n", "backend", "density", "write ch/s", "write MB/s", "cold us avg/p99", "warm us avg/p99", "files", "disk KB");
+
+    std::vector<std::unique_ptr<Chunk>> chunks;
+    for (double density : densities) {
+        synthesizeChunks(chunks, chunkCount, density, 1234);
+
+        // bytes the edits take in the game's own delta format, the same for every backend
+        size_t payloadBytes = 0;
+        for (const auto& chunk : chunks) {
+            payloadBytes += chunk->modifiedBlocks.size() * sizeof(BlockDelta::Entry);
+        }
+
+        for (const Backend& backend : BACKENDS) {
+            std::string folder = BENCH_FOLDER + "/" + std::to_string(&backend - BACKENDS);
+            std::filesystem::remove_all(folder);
+
+            double writeSeconds;
+            {
+                auto storage = backend.create(folder);
+                auto start = Clock::now();
+                for (auto& chunk : chunks) {
+                    chunk->savedGeneration = chunk->editGeneration - 1; // dirty again for every backend
+                    storage->write(*chunk);
+                }
+                storage->flush();
+                writeSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+            }
+
+            double coldAverage, coldP99, warmAverage, warmP99;
+            bool ok;
+            {
+                auto storage = backend.create(folder);
+                ok = measureReads(*storage, chunks, coldAverage, coldP99);
+                ok = measureReads(*storage, chunks, warmAverage, warmP99) && ok;
+            }
+
+            size_t files;
+            uintmax_t bytes;
+            folderStats(folder, files, bytes);
+
+            std::printf("%-16s %8.3f %12.0f %10.2f %7.1f/%-6.1f %7.1f/%-6.1f %7zu %11.1f%s\n",
+                backend.name, density,
+                chunks.size() / writeSeconds, payloadBytes / writeSeconds / (1024.0 * 1024.0),
+                coldAverage, coldP99, warmAverage, warmP99,
+                files, bytes / 1024.0, ok ? "" : "  READ MISMATCH");
+
+            std::filesystem::remove_all(folder);
+        }
+    }
+
+    std::filesystem::remove_all(BENCH_FOLDER);
+    return 0;
+}
\ No newline at end of file
@@ -2,4 +2,31 @@
 
 static constexpr int CHUNK_SIZE = 16;
 static constexpr int RENDER_DISTANCE = 10;
-static constexpr int VERTICAL_RENDER_DISTANCE = 6; // vertical render distance in chunks
\ No newline at end of file
+static constexpr int VERTICAL_RENDER_DISTANCE = 6; // vertical render distance in chunks
+
+// chebyshev distance from the player chunk (in chunks) where meshes switch to 2x / 4x downsampled blocks
+// scaled from the render radius (RENDER_DISTANCE / 2) so only the outer rings are downsampled, 4 and 5 at the default distance
+static constexpr int LOD2_DISTANCE = RENDER_DISTANCE / 2 * 3 / 4 + 1;
+static constexpr int LOD4_DISTANCE = RENDER_DISTANCE / 2 * 7 / 8 + 1;
+
+// an edited chunk keeps its per face mesh until it had no edits for this long, then it's meshed normally again
+static constexpr int MESH_CONSOLIDATE_DELAY_MS = 5000;
+
+// meshing threads, 0 - hardware threads minus the main and generation thread
+static constexpr int MESH_WORKER_COUNT = 0;
+
+// keep generated chunks on disk (worlds/<seed>/cache) so chunks coming back into range skip generation
+static constexpr bool CHUNK_SNAPSHOT_CACHE = true;
+
+// slots of the loaded chunk window (powers of two, at least the loaded area: 2 * (distance / 2 + 1) + 1)
+static constexpr int CHUNK_GRID_SIZE = 16;
+static constexpr int CHUNK_GRID_HEIGHT = 16;
+
+// unloaded chunks kept around for reuse, about one slice of the loaded area
+static constexpr int CHUNK_POOL_CAPACITY = 256;
+
+// order of blocks inside a chunk's storage, see world/block_layout.h (bench/layout_bench compares them)
+// Linear - x + y*16 + z*256, rows along x are contiguous (meshing copies whole rows)
+// Morton - x/y/z bits interleaved, blocks close in 3d are close in memory (raycasts, neighbor tests, LOD downsampling)
+enum class BlockLayout { Linear, Morton };
+static constexpr BlockLayout BLOCK_LAYOUT = BlockLayout::Linear;
@@ -133,6 +133,11 @@ void App::run() {
 
 		renderSystem->update(transformComponents, renderComponents, *cameraComponent);
 
+        // folds the edit journal into region storage before it gets long, in the background
+        if (world->journal.size() >= JOURNAL_CHECKPOINT_BYTES) {
+            renderSystem->autosaveWorld();
+        }
+
         App::fpsCounter++;
         if (currentTime - lastTime >= 1.0) {
             App::fps = App::fpsCounter;
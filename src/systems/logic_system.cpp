@@ -1,5 +1,6 @@
 #include "logic_system.h"
 #include "render_system.h"
+#include <iostream>
 
 LogicSystem::LogicSystem(GLFWwindow* window, World* w, RenderSystem* renderSystem) : left_click(GLFW_MOUSE_BUTTON_LEFT, true, 1, window, 0.2f), right_click(GLFW_MOUSE_BUTTON_RIGHT, true, 1, window, 0.2f), middle_click(GLFW_MOUSE_BUTTON_MIDDLE, false, 1, window) {
     player = new Player();
@@ -70,32 +71,7 @@ void LogicSystem::updatePlayerSlotKeys(){
     }
 }
 
-const int neighborOffsets[6][3] = {
-            {1, 0, 0}, {-1, 0, 0},
-            {0, 1, 0}, {0, -1, 0},
-            {0, 0, 1}, {0, 0, -1}
-        };
-
-void LogicSystem::handlePlayerMouseClick(RaycastHit hit, std::shared_mutex& chunkMapMutex, std::shared_mutex& meshCreationQueueMutex, MeshSystem& meshSystem, std::unordered_map<uint64_t, Mesh>& chunksMesh){
-    auto createChunkMesh = [&](Chunk& chunk) -> Mesh {
-        int cx = chunk.position.x / CHUNK_SIZE;
-        int cy = chunk.position.y / CHUNK_SIZE;
-        int cz = chunk.position.z / CHUNK_SIZE;
-       
-        std::array<std::shared_ptr<Chunk>, 6> neighbors;
-        {
-            for (int i = 0; i < 6; ++i) {
-                uint64_t nHash = hashChunkCoords(cx + neighborOffsets[i][0], cy + neighborOffsets[i][1], cz + neighborOffsets[i][2]);
-                auto it = world->chunkMap.find(nHash);
-                neighbors[i] = (it != world->chunkMap.end()) ? it->second : nullptr;
-            }
-        }
-
-        MeshData data = meshSystem.createChunkData(chunk, neighbors);
-        Mesh mesh = meshSystem.createMesh(data);
-        return mesh;
-    };
-    
+void LogicSystem::handlePlayerMouseClick(RaycastHit hit, std::shared_mutex& chunkGridMutex, std::shared_mutex& meshCreationQueueMutex, MeshSystem& meshSystem, std::unordered_map<uint64_t, Mesh>& chunksMesh){
     try
         {
             int x = hit.block.position.x;
@@ -103,7 +79,7 @@ void LogicSystem::handlePlayerMouseClick(RaycastHit hit, std::shared_mutex& chun
             int z = hit.block.position.z;
 
             if(middle_click.isPressed()){
-                std::unique_lock lock(chunkMapMutex);
+                std::unique_lock lock(chunkGridMutex);
                 int cx = x / CHUNK_SIZE;
                 if (x < 0 && x % CHUNK_SIZE != 0) --cx;
                 int cy = y / CHUNK_SIZE;
@@ -111,8 +87,9 @@ void LogicSystem::handlePlayerMouseClick(RaycastHit hit, std::shared_mutex& chun
                 int cz = z / CHUNK_SIZE;
                 if (z < 0 && z % CHUNK_SIZE != 0) --cz;
 
-                uint64_t hash = hashChunkCoords(cx, cy, cz);
-                Chunk& chunk = *world->chunkMap.at(hash);
+                Chunk* found = world->chunkGrid.find(cx, cy, cz);
+                if (!found) return;
+                Chunk& chunk = *found;
 
                 // Local coordinates inside the chunk
                 int localX = x - cx * CHUNK_SIZE;
@@ -150,7 +127,7 @@ void LogicSystem::handlePlayerMouseClick(RaycastHit hit, std::shared_mutex& chun
             }
 
             if(right_click.isPressed()) {
-                std::scoped_lock lock(meshCreationQueueMutex, chunkMapMutex);
+                std::scoped_lock lock(meshCreationQueueMutex, chunkGridMutex);
                 int wx = x + hit.faceNormal.x;
                 int wy = y + hit.faceNormal.y;
                 int wz = z + hit.faceNormal.z;
@@ -162,8 +139,9 @@ void LogicSystem::handlePlayerMouseClick(RaycastHit hit, std::shared_mutex& chun
                 int cz = wz / CHUNK_SIZE;
                 if (wz < 0 && wz % CHUNK_SIZE != 0) --cz;
 
-                uint64_t hash = hashChunkCoords(cx, cy, cz);
-                Chunk& chunk = *world->chunkMap.at(hash);
+                Chunk* found = world->chunkGrid.find(cx, cy, cz);
+                if (!found) return;
+                Chunk& chunk = *found;
 
                 // Local coordinates inside the chunk
                 int localX = wx - cx * CHUNK_SIZE;
@@ -172,21 +150,22 @@ void LogicSystem::handlePlayerMouseClick(RaycastHit hit, std::shared_mutex& chun
                 
                 int id =  player->inventory.getSelectedItem().id;
 
+                world->beginBlockEdit(chunk);
                 changeBlockID(chunk, localX, localY, localZ, id);
                 
                 if(id == 17){ // wood
                     uint8_t rotation = getRotationFromNormal(hit.faceNormal);
                     changeBlockRotation(chunk, localX, localY, localZ, rotation);
                 }
+                world->endBlockEdit(chunk);
 
-                Mesh mesh = createChunkMesh(chunk);
-                mesh.startPositonOfChunk = {cx * CHUNK_SIZE, cy * CHUNK_SIZE, cz * CHUNK_SIZE};
+                world->journal.record(wx, wy, wz, getBlock(chunk, localX, localY, localZ));
 
-                chunksMesh[hash] = mesh;
+                meshSystem.updateMeshDataWithBlock(chunksMesh, world->chunkGrid, chunk, localX, localY, localZ);
             }
 
             if(left_click.isPressed()) {
-                std::scoped_lock lock(meshCreationQueueMutex, chunkMapMutex);
+                std::scoped_lock lock(meshCreationQueueMutex, chunkGridMutex);
 
                 int cx = x / CHUNK_SIZE;
                 if (x < 0 && x % CHUNK_SIZE != 0) --cx;
@@ -195,81 +174,22 @@ void LogicSystem::handlePlayerMouseClick(RaycastHit hit, std::shared_mutex& chun
                 int cz = z / CHUNK_SIZE;
                 if (z < 0 && z % CHUNK_SIZE != 0) --cz;
 
-                uint64_t hash = hashChunkCoords(cx, cy, cz);
-                Chunk& chunk = *world->chunkMap.at(hash);
+                Chunk* found = world->chunkGrid.find(cx, cy, cz);
+                if (!found) return;
+                Chunk& chunk = *found;
 
                 // Local coordinates inside the chunk
                 int localX = x - cx * CHUNK_SIZE;
                 int localY = y - cy * CHUNK_SIZE;
                 int localZ = z - cz * CHUNK_SIZE;
                 
+                world->beginBlockEdit(chunk);
                 changeBlockID(chunk, localX, localY, localZ, 0);
+                world->endBlockEdit(chunk);
+                world->journal.record(x, y, z, getBlock(chunk, localX, localY, localZ));
 
-                Mesh mesh = createChunkMesh(chunk);
-
-                mesh.startPositonOfChunk = {cx * CHUNK_SIZE, cy * CHUNK_SIZE, cz * CHUNK_SIZE};
-
-                chunksMesh[hash] = mesh;
-
-                if(localX == 0){
-                    uint64_t hash = hashChunkCoords(cx - 1, cy, cz);
-                    Chunk& chunk = *world->chunkMap.at(hash);
-
-                    Mesh mesh = createChunkMesh(chunk);
-
-                    mesh.startPositonOfChunk = {(cx - 1) * CHUNK_SIZE, cy * CHUNK_SIZE, cz * CHUNK_SIZE};
-
-                    chunksMesh[hash] = mesh;
-                }else if(localX == CHUNK_SIZE - 1){
-                    uint64_t hash = hashChunkCoords(cx + 1, cy, cz);
-                    Chunk& chunk = *world->chunkMap.at(hash);
-
-                    Mesh mesh = createChunkMesh(chunk);
-
-                    mesh.startPositonOfChunk = {(cx + 1) * CHUNK_SIZE, cy * CHUNK_SIZE, cz * CHUNK_SIZE};
-
-                    chunksMesh[hash] = mesh;
-                }
-                
-                if(localY == 0){
-                    uint64_t hash = hashChunkCoords(cx, cy - 1, cz);
-                    Chunk& chunk = *world->chunkMap.at(hash);
-
-                    Mesh mesh = createChunkMesh(chunk);
-
-                    mesh.startPositonOfChunk = {cx * CHUNK_SIZE, (cy - 1) * CHUNK_SIZE, cz * CHUNK_SIZE};
-
-                    chunksMesh[hash] = mesh;
-                }else if(localY == CHUNK_SIZE - 1){
-                    uint64_t hash = hashChunkCoords(cx, cy + 1, cz);
-                    Chunk& chunk = *world->chunkMap.at(hash);
-
-                    Mesh mesh = createChunkMesh(chunk);
-
-                    mesh.startPositonOfChunk = {cx * CHUNK_SIZE, (cy + 1) * CHUNK_SIZE, cz * CHUNK_SIZE};
-
-                    chunksMesh[hash] = mesh;
-                }
-                
-                if(localZ == 0){
-                    uint64_t hash = hashChunkCoords(cx, cy, cz - 1);
-                    Chunk& chunk = *world->chunkMap.at(hash);
-
-                    Mesh mesh = createChunkMesh(chunk);
-
-                    mesh.startPositonOfChunk = {cx * CHUNK_SIZE, cy * CHUNK_SIZE, (cz - 1) * CHUNK_SIZE};
-
-                    chunksMesh[hash] = mesh;
-                }else if(localZ == CHUNK_SIZE - 1){
-                    uint64_t hash = hashChunkCoords(cx, cy, cz + 1);
-                    Chunk& chunk = *world->chunkMap.at(hash);
-
-                    Mesh mesh = createChunkMesh(chunk);
-
-                    mesh.startPositonOfChunk = {cx * CHUNK_SIZE, cy * CHUNK_SIZE, (cz + 1) * CHUNK_SIZE};
-                    
-                    chunksMesh[hash] = mesh;
-                }
+                // patches neighbor chunk meshes too when the block is on the border
+                meshSystem.updateMeshDataWithBlock(chunksMesh, world->chunkGrid, chunk, localX, localY, localZ);
             }
         }
         catch(const std::exception& e)
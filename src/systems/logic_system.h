@@ -18,7 +18,7 @@ public:
     ~LogicSystem();
 
     void update(float dt);
-    void handlePlayerMouseClick(RaycastHit hit, std::shared_mutex& chunkMapMutex, std::shared_mutex& meshCreationQueueMutex, MeshSystem& meshSystem, std::unordered_map<uint64_t, Mesh>& chunksMesh);
+    void handlePlayerMouseClick(RaycastHit hit, std::shared_mutex& chunkGridMutex, std::shared_mutex& meshCreationQueueMutex, MeshSystem& meshSystem, std::unordered_map<uint64_t, Mesh>& chunksMesh);
     void updatePlayerSlotKeys();
     void scroll(double xoffset, double yoffset);
 
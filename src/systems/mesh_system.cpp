@@ -5,6 +5,10 @@
 #include <world.h>
 #include <array>
 #include <memory>
+#include <algorithm>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
 
 Mesh MeshSystem::createMesh(MeshData& meshData) {
     Mesh mesh;
@@ -34,300 +38,749 @@ Mesh MeshSystem::createMesh(MeshData& meshData) {
     glVertexAttribIPointer(2, 1, GL_UNSIGNED_BYTE, sizeof(Vertex), (void*)offsetof(Vertex, light));
     glEnableVertexAttribArray(2);
 
+
     glBindVertexArray(0);
 
     mesh.indexCount = meshData.indices.size();
-    mesh.data = std::move(meshData);
+    mesh.gpuBytes = meshData.vertices.size() * sizeof(Vertex) + meshData.indices.size() * sizeof(unsigned int);
+    gpuMeshBytes += mesh.gpuBytes;
     return mesh;
 }
 
-MeshData MeshSystem::createChunkData(const Chunk& chunk, const std::array<std::shared_ptr<Chunk>, 6>& neighbors, int LOD) {
-    std::vector<Vertex> vertices;
-    std::vector<unsigned int> indices;
-    unsigned int indexOffset = 0;
-
-    glm::vec3 faceVerts[6][4] = {
-        // -Z (front)
-        { {0,0,0}, {1,0,0}, {1,1,0}, {0,1,0} },
-        // +Z (back)
-        { {1,0,1}, {0,0,1}, {0,1,1}, {1,1,1} },
-        // -X (left)
-        { {0,0,0}, {0,1,0}, {0,1,1}, {0,0,1} },
-        // +X (right)
-        { {1,0,0}, {1,0,1}, {1,1,1}, {1,1,0} },
-        // +Y (top)
-        { {0,1,0}, {1,1,0}, {1,1,1}, {0,1,1} },
-        // -Y (bottom)
-        { {0,0,0}, {0,0,1}, {1,0,1}, {1,0,0} }
-    };
+Mesh MeshSystem::createChunkMesh(ChunkMeshData& meshData) {
+    return createChunkMesh(meshData, chunkMeshResidency);
+}
 
-    glm::vec3 faceNormals[6] = {
-        {0,0,-1}, {0,0,1}, {-1,0,0}, {1,0,0}, {0,1,0}, {0,-1,0}
-    };
+// empty meshes (air, buried chunks) get no GL objects, they're skipped when drawing
+Mesh MeshSystem::createChunkMesh(ChunkMeshData& meshData, MeshResidency residency) {
+    Mesh mesh;
+    mesh.VAO = mesh.VBO = mesh.EBO = 0;
+    mesh.indexCount = 0;
+    mesh.lod = meshData.lod;
+    mesh.airBorders = meshData.airBorders;
+    mesh.residency = residency;
+
+    if (meshData.vertices.empty()) {
+        meshData = ChunkMeshData();
+        return mesh;
+    }
 
-    // corresponds to E, W, U, D, N, S
-    const int neighbor_map[6][3] = {
-        {1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1}
-    };
+    glGenVertexArrays(1, &mesh.VAO);
+    glBindVertexArray(mesh.VAO);
+
+    glGenBuffers(1, &mesh.VBO);
+    glBindBuffer(GL_ARRAY_BUFFER, mesh.VBO);
+    glBufferData(GL_ARRAY_BUFFER, meshData.vertices.size() * sizeof(ChunkVertex),
+                 meshData.vertices.data(), GL_STATIC_DRAW);
+
+    mesh.EBO = 0;
+    bindQuadIndexBuffer(mesh, meshData.vertices.size() / 4);
+
+    // Position, face, uv rotation and light
+    glVertexAttribIPointer(0, 1, GL_UNSIGNED_INT, sizeof(ChunkVertex), (void*)offsetof(ChunkVertex, data));
+    glEnableVertexAttribArray(0);
+
+    // Atlas tile
+    glVertexAttribIPointer(1, 1, GL_UNSIGNED_SHORT, sizeof(ChunkVertex), (void*)offsetof(ChunkVertex, tile));
+    glEnableVertexAttribArray(1);
+
+    glBindVertexArray(0);
+
+    mesh.indexCount = meshData.vertices.size() / 4 * 6;
+    mesh.gpuBytes = meshData.vertices.size() * sizeof(ChunkVertex);
+    gpuMeshBytes += mesh.gpuBytes;
+
+    if (residency == MeshResidency::Retained) {
+        mesh.data = std::move(meshData);
+        mesh.cpuBytes = mesh.data.vertices.capacity() * sizeof(ChunkVertex);
+        cpuMeshBytes += mesh.cpuBytes;
+    } else {
+        // free the cpu copy now instead of whenever the caller drops it
+        meshData = ChunkMeshData();
+    }
+
+    return mesh;
+}
+
+static std::vector<uint32_t> makeQuadIndices(uint32_t quadCount) {
+    std::vector<uint32_t> indices;
+    indices.reserve(quadCount * 6);
+    for (uint32_t quad = 0; quad < quadCount; quad++) {
+        uint32_t indexOffset = quad * 4;
+        indices.push_back(indexOffset + 0);
+        indices.push_back(indexOffset + 2);
+        indices.push_back(indexOffset + 1);
+        indices.push_back(indexOffset + 0);
+        indices.push_back(indexOffset + 3);
+        indices.push_back(indexOffset + 2);
+    }
+    return indices;
+}
+
+// binds the shared quad index buffer to the mesh VAO (has to be bound), 16 bit while the mesh fits
+// buffers are made on first use and the 32 bit one only grows, VAOs keep pointing at the same buffer name
+void MeshSystem::bindQuadIndexBuffer(Mesh& mesh, uint32_t quadCount) {
+    if (quadCount <= MAX_QUADS_16BIT) {
+        if (quadIndexBuffer16 == 0) {
+            std::vector<uint32_t> indices32 = makeQuadIndices(MAX_QUADS_16BIT);
+            std::vector<uint16_t> indices(indices32.begin(), indices32.end());
+            glGenBuffers(1, &quadIndexBuffer16);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, quadIndexBuffer16);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint16_t), indices.data(), GL_STATIC_DRAW);
+            gpuMeshBytes += indices.size() * sizeof(uint16_t);
+        }
 
-    auto isAir = [&](int x, int y, int z) -> bool {
-        int c_cx = chunk.position.x / CHUNK_SIZE;
-        int c_cy = chunk.position.y / CHUNK_SIZE;
-        int c_cz = chunk.position.z / CHUNK_SIZE;
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, quadIndexBuffer16);
+        mesh.indexType = GL_UNSIGNED_SHORT;
+        return;
+    }
 
-        int n_cx = floor(static_cast<float>(x) / CHUNK_SIZE);
-        int n_cy = floor(static_cast<float>(y) / CHUNK_SIZE);
-        int n_cz = floor(static_cast<float>(z) / CHUNK_SIZE);
+    if (quadCount > quadIndexCapacity32) {
+        uint32_t capacity = std::max(quadCount, quadIndexCapacity32 * 2);
+        std::vector<uint32_t> indices = makeQuadIndices(capacity);
 
-        if (n_cx == c_cx && n_cy == c_cy && n_cz == c_cz) {
-            return getBlockID(chunk, getLocalCoord(x), getLocalCoord(y), getLocalCoord(z)) == 0;
+        if (quadIndexBuffer32 == 0) {
+            glGenBuffers(1, &quadIndexBuffer32);
         }
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, quadIndexBuffer32);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint32_t), indices.data(), GL_STATIC_DRAW);
+
+        gpuMeshBytes -= quadIndexCapacity32 * 6 * sizeof(uint32_t);
+        gpuMeshBytes += indices.size() * sizeof(uint32_t);
+        quadIndexCapacity32 = capacity;
+    }
 
-        int dx = n_cx - c_cx;
-        int dy = n_cy - c_cy;
-        int dz = n_cz - c_cz;
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, quadIndexBuffer32);
+    mesh.indexType = GL_UNSIGNED_INT;
+}
 
-        for (int i = 0; i < 6; ++i) {
-            if (dx == neighbor_map[i][0] && dy == neighbor_map[i][1] && dz == neighbor_map[i][2]) {
-                const auto& neighbor_chunk = neighbors[i];
-                if (neighbor_chunk) {
-                    return getBlockID(*neighbor_chunk, getLocalCoord(x), getLocalCoord(y), getLocalCoord(z)) == 0;
+void MeshSystem::deleteQuadIndexBuffers() {
+    if (quadIndexBuffer16 != 0) {
+        glDeleteBuffers(1, &quadIndexBuffer16);
+        gpuMeshBytes -= MAX_QUADS_16BIT * 6 * sizeof(uint16_t);
+        quadIndexBuffer16 = 0;
+    }
+
+    if (quadIndexBuffer32 != 0) {
+        glDeleteBuffers(1, &quadIndexBuffer32);
+        gpuMeshBytes -= quadIndexCapacity32 * 6 * sizeof(uint32_t);
+        quadIndexBuffer32 = 0;
+        quadIndexCapacity32 = 0;
+    }
+}
+
+static const glm::vec3 faceVerts[6][4] = {
+    // -Z (front)
+    { {0,0,0}, {1,0,0}, {1,1,0}, {0,1,0} },
+    // +Z (back)
+    { {1,0,1}, {0,0,1}, {0,1,1}, {1,1,1} },
+    // -X (left)
+    { {0,0,0}, {0,1,0}, {0,1,1}, {0,0,1} },
+    // +X (right)
+    { {1,0,0}, {1,0,1}, {1,1,1}, {1,1,0} },
+    // +Y (top)
+    { {0,1,0}, {1,1,0}, {1,1,1}, {0,1,1} },
+    // -Y (bottom)
+    { {0,0,0}, {0,0,1}, {1,0,1}, {1,0,0} }
+};
+
+static const glm::ivec3 faceNormals[6] = {
+    {0,0,-1}, {0,0,1}, {-1,0,0}, {1,0,0}, {0,1,0}, {0,-1,0}
+};
+
+// axis the face normal points along (0 - x, 1 - y, 2 - z)
+static const int faceAxis[6] = { 2, 2, 0, 0, 1, 1 };
+
+// corresponds to E, W, U, D, N, S
+static const int neighbor_map[6][3] = {
+    {1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1}
+};
+
+// neighbors are in neighbor_map order, pointers only need to stay valid during the copy
+void MeshSystem::fillPaddedChunk(PaddedChunk& padded, const Chunk& chunk, const std::array<const Chunk*, 6>& neighbors) {
+    padded.position = chunk.position;
+
+    if constexpr (BLOCK_LAYOUT == BlockLayout::Linear) {
+        for (int z = 0; z < CHUNK_SIZE; z++) {
+            for (int y = 0; y < CHUNK_SIZE; y++) {
+                chunk.blocks.unpackRange(blockIndex(0, y, z), CHUNK_SIZE, &padded.blocks[getPaddedIndex(0, y, z)]);
+            }
+        }
+    } else {
+        // rows aren't contiguous, unpack everything once and scatter
+        std::array<BlockData, CHUNK_VOLUME> blocks;
+        chunk.blocks.unpack(blocks.data());
+        for (int z = 0; z < CHUNK_SIZE; z++) {
+            for (int y = 0; y < CHUNK_SIZE; y++) {
+                for (int x = 0; x < CHUNK_SIZE; x++) {
+                    padded.blocks[getPaddedIndex(x, y, z)] = blocks[blockIndex(x, y, z)];
                 }
-                break;
             }
         }
+    }
 
-        return true;
-    };
+    for (int i = 0; i < 6; i++) {
+        int n = neighbor_map[i][0] != 0 ? 0 : (neighbor_map[i][1] != 0 ? 1 : 2);
+        int u = (n + 1) % 3;
+        int v = (n + 2) % 3;
+        bool positive = neighbor_map[i][n] > 0;
+
+        for (int b = 0; b < CHUNK_SIZE; b++) {
+            for (int a = 0; a < CHUNK_SIZE; a++) {
+                glm::ivec3 src, dst;
+                src[n] = positive ? 0 : CHUNK_SIZE - 1;
+                dst[n] = positive ? CHUNK_SIZE : -1;
+                src[u] = dst[u] = a;
+                src[v] = dst[v] = b;
+
+                BlockData& border = padded.blocks[getPaddedIndex(dst.x, dst.y, dst.z)];
+                border = neighbors[i] ? neighbors[i]->blocks.get(blockIndex(src.x, src.y, src.z)) : BlockData();
+            }
+        }
+    }
+}
+
+// true when meshing would give no faces at all - a chunk of only air, or of one solid block
+// with every neighbor loaded and solid on the side facing it (missing neighbors count as air)
+bool MeshSystem::isChunkHidden(const Chunk& chunk, const std::array<const Chunk*, 6>& neighbors) {
+    if (!chunk.blocks.isUniform()) return false;
+    if (chunk.blocks.get(0).id == 0) return true;
+
+    for (int i = 0; i < 6; i++) {
+        // the neighbor's face touching this chunk is the opposite one (faces are in neighbor_map order)
+        if (!neighbors[i] || !neighbors[i]->blocks.isFaceSolid(i ^ 1)) return false;
+    }
+
+    return true;
+}
+
+// LOD 2 and 4 mesh a downsampled copy, cells of LOD^3 blocks become one block so the merge makes LOD sized quads
+ChunkMeshData MeshSystem::createChunkData(const PaddedChunk& chunk, int LOD) {
+    if (LOD > 1) {
+        auto downsampled = std::make_unique<PaddedChunk>(chunk);
+        downsamplePaddedChunk(*downsampled, LOD);
+
+        ChunkMeshData data = createChunkData(*downsampled);
+        data.lod = LOD;
+        return data;
+    }
+
+    if (meshingMode == MeshingMode::PerFace) {
+        return createChunkDataPerFace(chunk);
+    }
+
+    if (meshingMode == MeshingMode::Greedy) {
+        return createChunkDataGreedy(chunk);
+    }
+
+    return createChunkDataBinary(chunk);
+}
+
+// fills every LOD^3 cell with a single block, the border from the neighbors stays full size
+// (at LOD seams the border is air, see lodAirBorders in render_system.cpp, so faces toward other LODs are always drawn)
+// a cell is solid when at least half of it is, then it takes its highest solid block so grass stays on top
+void MeshSystem::downsamplePaddedChunk(PaddedChunk& chunk, int LOD) {
+    const int cellVolume = LOD * LOD * LOD;
+
+    for (int cz = 0; cz < CHUNK_SIZE; cz += LOD) {
+        for (int cy = 0; cy < CHUNK_SIZE; cy += LOD) {
+            for (int cx = 0; cx < CHUNK_SIZE; cx += LOD) {
+                int solidCount = 0;
+                BlockData top;
+
+                for (int y = cy + LOD - 1; y >= cy; y--) {
+                    for (int z = cz; z < cz + LOD; z++) {
+                        for (int x = cx; x < cx + LOD; x++) {
+                            const BlockData& blockData = chunk.blocks[getPaddedIndex(x, y, z)];
+                            if (blockData.id == 0) continue;
+
+                            if (solidCount == 0) top = blockData;
+                            solidCount++;
+                        }
+                    }
+                }
+
+                BlockData cell = solidCount * 2 >= cellVolume ? top : BlockData();
+
+                for (int z = cz; z < cz + LOD; z++) {
+                    for (int y = cy; y < cy + LOD; y++) {
+                        for (int x = cx; x < cx + LOD; x++) {
+                            chunk.blocks[getPaddedIndex(x, y, z)] = cell;
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+// reference mesher, one quad for every visible face
+ChunkMeshData MeshSystem::createChunkDataPerFace(const PaddedChunk& chunk) {
+    ChunkMeshData data;
 
     for(int dz=0; dz<CHUNK_SIZE; dz++){
         for(int dy=0; dy<CHUNK_SIZE; dy++){
             for(int dx=0; dx<CHUNK_SIZE; dx++){
-                const BlockData& blockData = chunk.blocks[dx + dy * CHUNK_SIZE + dz * CHUNK_SIZE * CHUNK_SIZE];
-                uint8_t id = blockData.id;
-                if (id == 0) continue; // skip air blocks
-
-                int x = dx + chunk.position.x;
-                int y = dy + chunk.position.y;
-                int z = dz + chunk.position.z;
+                const BlockData& blockData = chunk.blocks[getPaddedIndex(dx, dy, dz)];
+                if (blockData.id == 0) continue; // skip air blocks
 
                 for(int f=0; f<6; f++){
-                    glm::ivec3 neighbor = glm::ivec3(x,y,z) + glm::ivec3(faceNormals[f]);
-                    if(isAir(neighbor.x, neighbor.y, neighbor.z)){
-
-                        // --- UV selection ---
-                        int ty = (id - 1) * blockTexSize;
-                        int tx;
-
-                        // 0: Side, 1: Bottom, 2: Top
-                        int faceTextureType = 0; // texture for side
-                        switch (blockData.rotation) {
-                            case 0: // normal rotation
-                                if (f == 4) faceTextureType = 2; // Top face
-                                if (f == 5) faceTextureType = 1; // Bottom face
-                                break;
-                            case 1: // -Z 
-                            case 3: // +Z face
-                                if (f == 0 || f == 1) faceTextureType = 2; // top texture
-                                break;
-                            case 2: // -X face
-                            case 4: // +X face
-                                if (f == 2 || f == 3) faceTextureType = 2; // bottom texture
-                                break;
-                        }
+                    glm::ivec3 neighbor = glm::ivec3(dx, dy, dz) + faceNormals[f];
+                    if(chunk.blocks[getPaddedIndex(neighbor.x, neighbor.y, neighbor.z)].id == 0){
+                        addQuad(data, glm::ivec3(dx, dy, dz), glm::ivec3(1), f, blockData);
+                    }
+                }
+            }
+        }
+    }
 
-                        if (faceTextureType == 0) tx = 0;                  // Side
-                        else if (faceTextureType == 1) tx = blockTexSize;     // Bottom
-                        else if (faceTextureType == 2) tx = blockTexSize * 2; // Top
+    return data;
+}
 
-                        float u0 = float(tx) / atlasWidthPixels;
-                        float v0 = float(ty) / atlasHeightPixels;
-                        float u1 = float(tx + blockTexSize) / atlasWidthPixels;
-                        float v1 = float(ty + blockTexSize) / atlasHeightPixels;
+// merges visible faces of every slice into rectangles, faces only merge when block id and rotation match (light is the same per direction)
+ChunkMeshData MeshSystem::createChunkDataGreedy(const PaddedChunk& chunk) {
+    ChunkMeshData data;
 
-                        glm::vec2 uvs[4] = {
-                            {u0, v1}, {u1, v1}, {u1, v0}, {u0, v0}
-                        };
+    // face key for every cell of the slice, 0 - no face
+    uint16_t mask[CHUNK_SIZE * CHUNK_SIZE];
 
-                        if (f == 2) { // -X face rotation for correct alaiwfuaaawdawdsgdyua
-                            rotateUV(uvs, 90);
-                        }
+    for (int f = 0; f < 6; f++) {
+        int n = faceAxis[f];
+        int u = (n + 1) % 3;
+        int v = (n + 2) % 3;
+
+        int neighborOffset = getPaddedIndex(faceNormals[f].x, faceNormals[f].y, faceNormals[f].z) - getPaddedIndex(0, 0, 0);
+
+        for (int d = 0; d < CHUNK_SIZE; d++) {
+            for (int b = 0; b < CHUNK_SIZE; b++) {
+                for (int a = 0; a < CHUNK_SIZE; a++) {
+                    glm::ivec3 local;
+                    local[n] = d;
+                    local[u] = a;
+                    local[v] = b;
+
+                    int index = getPaddedIndex(local.x, local.y, local.z);
+                    const BlockData& blockData = chunk.blocks[index];
+                    uint16_t key = 0;
 
-                        // 1  -Z rotation
-                        // 2  -X rotation
-                        // 3  +Z rotation
-                        // 4  +X rotation
+                    if (blockData.id != 0 && chunk.blocks[index + neighborOffset].id == 0) {
+                        key = blockData.id | (blockData.rotation << 8);
+                    }
+
+                    mask[a + b * CHUNK_SIZE] = key;
+                }
+            }
+
+            for (int b = 0; b < CHUNK_SIZE; b++) {
+                for (int a = 0; a < CHUNK_SIZE; ) {
+                    uint16_t key = mask[a + b * CHUNK_SIZE];
+                    if (key == 0) {
+                        a++;
+                        continue;
+                    }
 
-                        if ((blockData.rotation == 1 || blockData.rotation == 3) && (f == 2 || f == 3 || f == 5)) { // Z-aligned, top/bottom sides
-                            rotateUV(uvs, 90); // Rotate 90 degrees
+                    int w = 1;
+                    while (a + w < CHUNK_SIZE && mask[a + w + b * CHUNK_SIZE] == key) w++;
+
+                    int h = 1;
+                    bool canGrow = true;
+                    while (b + h < CHUNK_SIZE && canGrow) {
+                        for (int k = 0; k < w; k++) {
+                            if (mask[a + k + (b + h) * CHUNK_SIZE] != key) {
+                                canGrow = false;
+                                break;
+                            }
                         }
-                        
-                        if ((blockData.rotation == 2 || blockData.rotation == 4) && (f == 0 || f == 1 || f == 4)) { // X-aligned, front/back sides
-                            rotateUV(uvs, 90);  // Rotate 90 degrees
+                        if (canGrow) h++;
+                    }
+
+                    for (int j = 0; j < h; j++) {
+                        for (int k = 0; k < w; k++) {
+                            mask[a + k + (b + j) * CHUNK_SIZE] = 0;
                         }
+                    }
 
-                        uint8_t light = 255;
-                        if(f < 4) light = 200;
-                        if(f == 5) light = 150;
+                    glm::ivec3 local;
+                    local[n] = d;
+                    local[u] = a;
+                    local[v] = b;
 
+                    glm::ivec3 size(1);
+                    size[u] = w;
+                    size[v] = h;
 
-                        // Adds vertices
-                        for (int vert = 0; vert < 4; ++vert) {
-                            Vertex v;
-                            v.pos = glm::vec3(x + faceVerts[f][vert].x, y + faceVerts[f][vert].y, z + faceVerts[f][vert].z);
-                            v.texCoord = uvs[vert];
-                            v.light = light;
-                            vertices.push_back(v);
-                        }
+                    BlockData blockData;
+                    blockData.id = key & 0xFF;
+                    blockData.rotation = key >> 8;
+
+                    addQuad(data, local, size, f, blockData);
+
+                    a += w;
+                }
+            }
+        }
+    }
+
+    return data;
+}
+
+static inline int countTrailingZeros(uint32_t value) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, value);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctz(value);
+#endif
+}
 
-                        // Adds indices
-                        indices.push_back(indexOffset + 0);
-                        indices.push_back(indexOffset + 2);
-                        indices.push_back(indexOffset + 1);
-                        indices.push_back(indexOffset + 0);
-                        indices.push_back(indexOffset + 3);
-                        indices.push_back(indexOffset + 2);
+// CHUNK_SIZE is 16 so a padded column (18 blocks) fits in 32 bits and a slice row in 16 bits
+// visible faces come from shifts over whole columns, merging scans set bits instead of every cell
+ChunkMeshData MeshSystem::createChunkDataBinary(const PaddedChunk& chunk) {
+    static_assert(PADDED_CHUNK_SIZE <= 32, "padded column has to fit in uint32_t");
 
-                        indexOffset += 4;
+    ChunkMeshData data;
+
+    const int paddedStride[3] = { 1, PADDED_CHUNK_SIZE, PADDED_CHUNK_SIZE * PADDED_CHUNK_SIZE };
+
+    // solid bits along each axis, columns[axis][u][v] with u and v the next two axes (padded coords)
+    uint32_t columns[3][PADDED_CHUNK_SIZE][PADDED_CHUNK_SIZE] = {};
+
+    for (int z = 0; z < PADDED_CHUNK_SIZE; z++) {
+        for (int y = 0; y < PADDED_CHUNK_SIZE; y++) {
+            for (int x = 0; x < PADDED_CHUNK_SIZE; x++) {
+                if (chunk.blocks[x + y * paddedStride[1] + z * paddedStride[2]].id == 0) continue;
+
+                columns[0][y][z] |= 1u << x;
+                columns[1][z][x] |= 1u << y;
+                columns[2][x][y] |= 1u << z;
+            }
+        }
+    }
+
+    // visible faces of one direction, planes[d][v] has bit u set when the face at local (d, u, v) is visible
+    uint16_t planes[CHUNK_SIZE][CHUNK_SIZE];
+
+    for (int f = 0; f < 6; f++) {
+        int n = faceAxis[f];
+        int u = (n + 1) % 3;
+        int v = (n + 2) % 3;
+        bool positive = faceNormals[f][n] > 0;
+
+        std::memset(planes, 0, sizeof(planes));
+
+        for (int b = 0; b < CHUNK_SIZE; b++) {
+            for (int a = 0; a < CHUNK_SIZE; a++) {
+                uint32_t column = columns[n][a + 1][b + 1];
+                uint32_t faces = positive ? column & ~(column >> 1) : column & ~(column << 1);
+                faces = (faces >> 1) & 0xFFFF; // drop border blocks
+
+                while (faces) {
+                    int d = countTrailingZeros(faces);
+                    faces &= faces - 1;
+                    planes[d][b] |= 1 << a;
+                }
+            }
+        }
+
+        int base = getPaddedIndex(0, 0, 0);
+
+        for (int d = 0; d < CHUNK_SIZE; d++) {
+            auto keyAt = [&](int a, int b) -> uint16_t {
+                const BlockData& blockData = chunk.blocks[base + d * paddedStride[n] + a * paddedStride[u] + b * paddedStride[v]];
+                return blockData.id | (blockData.rotation << 8);
+            };
+
+            for (int b = 0; b < CHUNK_SIZE; b++) {
+                while (planes[d][b]) {
+                    uint32_t row = planes[d][b];
+                    int a = countTrailingZeros(row);
+                    uint16_t key = keyAt(a, b);
+
+                    // run of set bits from a, cut where the block changes
+                    int maxWidth = countTrailingZeros(~(row >> a));
+                    int w = 1;
+                    while (w < maxWidth && keyAt(a + w, b) == key) w++;
+
+                    uint16_t runMask = static_cast<uint16_t>(((1u << w) - 1) << a);
+
+                    int h = 1;
+                    while (b + h < CHUNK_SIZE && (planes[d][b + h] & runMask) == runMask) {
+                        bool sameKey = true;
+                        for (int k = 0; k < w; k++) {
+                            if (keyAt(a + k, b + h) != key) {
+                                sameKey = false;
+                                break;
+                            }
+                        }
+                        if (!sameKey) break;
+
+                        planes[d][b + h] &= ~runMask;
+                        h++;
                     }
+
+                    planes[d][b] &= ~runMask;
+
+                    glm::ivec3 local;
+                    local[n] = d;
+                    local[u] = a;
+                    local[v] = b;
+
+                    glm::ivec3 size(1);
+                    size[u] = w;
+                    size[v] = h;
+
+                    BlockData blockData;
+                    blockData.id = key & 0xFF;
+                    blockData.rotation = key >> 8;
+
+                    addQuad(data, local, size, f, blockData);
                 }
             }
         }
     }
 
-    MeshData data;
-    data.indices = indices;
-    data.vertices = std::move(vertices);
     return data;
 }
 
-void MeshSystem::rotateUV(glm::vec2 uvs[4], int rotation){
-    if(rotation == 90){
-        std::swap(uvs[0], uvs[3]); std::swap(uvs[0], uvs[1]); std::swap(uvs[1], uvs[2]);
-    }else if(rotation == -90){
-        std::swap(uvs[0], uvs[1]); std::swap(uvs[0], uvs[3]); std::swap(uvs[2], uvs[3]);
+// adds face f of a box of blocks starting at origin (local to the chunk)
+// texture uvs are derived from the position in the shader so they repeat once per block on merged quads
+void MeshSystem::addQuad(ChunkMeshData& data, const glm::ivec3& origin, const glm::ivec3& size, int f, const BlockData& blockData) {
+    // 0: Side, 1: Bottom, 2: Top
+    int faceTextureType = 0; // texture for side
+    switch (blockData.rotation) {
+        case 0: // normal rotation
+            if (f == 4) faceTextureType = 2; // Top face
+            if (f == 5) faceTextureType = 1; // Bottom face
+            break;
+        case 1: // -Z 
+        case 3: // +Z face
+            if (f == 0 || f == 1) faceTextureType = 2; // top texture
+            break;
+        case 2: // -X face
+        case 4: // +X face
+            if (f == 2 || f == 3) faceTextureType = 2; // bottom texture
+            break;
+    }
+
+    // 1  -Z rotation
+    // 2  -X rotation
+    // 3  +Z rotation
+    // 4  +X rotation
+
+    int uvRotation = 0;
+    if ((blockData.rotation == 1 || blockData.rotation == 3) && (f == 2 || f == 3 || f == 5)) { // Z-aligned, top/bottom sides
+        uvRotation = 1; // Rotate 90 degrees
+    }
+    
+    if ((blockData.rotation == 2 || blockData.rotation == 4) && (f == 0 || f == 1 || f == 4)) { // X-aligned, front/back sides
+        uvRotation = 1;  // Rotate 90 degrees
+    }
+
+    uint8_t light = 255;
+    if(f < 4) light = 200;
+    if(f == 5) light = 150;
+
+    // Adds vertices, indices come from the shared quad index buffer
+    for (int vert = 0; vert < 4; ++vert) {
+        glm::ivec3 pos = origin + glm::ivec3(faceVerts[f][vert]) * size;
+        data.vertices.push_back(packChunkVertex(pos.x, pos.y, pos.z, f, uvRotation, light, faceTextureType, blockData.id - 1));
     }
 }
 
-// maybe will use some day
-// void MeshSystem::updateMeshDataWithBlock(Mesh& mesh, const Chunk& chunk, const std::unordered_map<uint64_t, std::shared_ptr<Chunk>>& chunkMap, int x, int y, int z) {
-//     MeshData& meshData = mesh.data;
-
-//     // This lambda should be refactored into a helper if used in multiple places.
-//     auto isAir = [&](int gx, int gy, int gz) -> bool {
-//         int cx = floor(gx / float(CHUNK_SIZE));
-//         int cy = floor(gy / float(CHUNK_SIZE));
-//         int cz = floor(gz / float(CHUNK_SIZE));
-
-//         int lx = gx - cx * CHUNK_SIZE;
-//         int ly = gy - cy * CHUNK_SIZE;
-//         int lz = gz - cz * CHUNK_SIZE;
-
-//         uint64_t key = hashChunkCoords(cx, cy, cz);
-//         auto it = chunkMap.find(key);
-//         if(it == chunkMap.end()) return true; // treat missing chunk as air
+// per-face mesh with a slot for every quad, built the first time a chunk gets edited
+// buffers get some spare slots so the next edits dont have to reallocate
+Mesh MeshSystem::createEditableChunkMesh(const PaddedChunk& chunk) {
+    ChunkMeshData data;
+    MeshEditState edit;
+    edit.active = true;
+
+    for (int dz = 0; dz < CHUNK_SIZE; dz++) {
+        for (int dy = 0; dy < CHUNK_SIZE; dy++) {
+            for (int dx = 0; dx < CHUNK_SIZE; dx++) {
+                const BlockData& blockData = chunk.blocks[getPaddedIndex(dx, dy, dz)];
+                if (blockData.id == 0) continue;
+
+                for (int f = 0; f < 6; f++) {
+                    glm::ivec3 neighbor = glm::ivec3(dx, dy, dz) + faceNormals[f];
+                    if (chunk.blocks[getPaddedIndex(neighbor.x, neighbor.y, neighbor.z)].id != 0) continue;
+
+                    uint32_t faceBlock = linearBlockIndex(dx, dy, dz);
+                    edit.faceSlots[faceBlock * 6 + f] = edit.quadCount++;
+                    addQuad(data, glm::ivec3(dx, dy, dz), glm::ivec3(1), f, blockData);
+                }
+            }
+        }
+    }
 
-//         const auto& c_ptr = it->second;
-//         return c_ptr->blocks[lx + ly*CHUNK_SIZE + lz*CHUNK_SIZE*CHUNK_SIZE].id == 0;
-//     };
+    edit.quadCapacity = edit.quadCount + std::max<uint32_t>(64, edit.quadCount / 4);
+    data.vertices.resize(edit.quadCapacity * 4, ChunkVertex{}); // zeroed quads are degenerate
 
-//     // Use the same face definitions as createChunkData for consistency
-//     static const glm::vec3 faceVerts[6][4] = {
-//         { {0,0,0}, {1,0,0}, {1,1,0}, {0,1,0} }, // -Z
-//         { {1,0,1}, {0,0,1}, {0,1,1}, {1,1,1} }, // +Z
-//         { {0,0,0}, {0,1,0}, {0,1,1}, {0,0,1} }, // -X
-//         { {1,0,0}, {1,0,1}, {1,1,1}, {1,1,0} }, // +X
-//         { {0,1,0}, {1,1,0}, {1,1,1}, {0,1,1} }, // +Y
-//         { {0,0,0}, {0,0,1}, {1,0,1}, {1,0,0} }  // -Y
-//     };
+    Mesh mesh = createChunkMesh(data, MeshResidency::Retained);
+    mesh.indexCount = edit.quadCount * 6;
+    edit.lastEdit = std::chrono::steady_clock::now();
+    mesh.startPositonOfChunk = chunk.position;
+    mesh.edit = std::move(edit);
+    return mesh;
+}
 
-//     static const glm::vec3 faceNormals[6] = {
-//         {0,0,-1}, {0,0,1}, {-1,0,0}, {1,0,0}, {0,1,0}, {0,-1,0}
-//     };
+// re-checks the faces that can change when block x y z (local to chunk) is placed or broken:
+// the 6 faces of the block and the face of each neighbor that looks at it, neighbor chunk meshes included
+// meshes get switched to the editable per-face layout on first edit, after that an edit only uploads the changed quads
+void MeshSystem::updateMeshDataWithBlock(std::unordered_map<uint64_t, Mesh>& chunksMesh, const ChunkGrid& chunkGrid, const Chunk& chunk, int x, int y, int z) {
+    int cx = chunk.position.x / CHUNK_SIZE;
+    int cy = chunk.position.y / CHUNK_SIZE;
+    int cz = chunk.position.z / CHUNK_SIZE;
 
-//     uint8_t id = chunk.blocks[x + y*CHUNK_SIZE + z*CHUNK_SIZE*CHUNK_SIZE];
-//     if (id == 0) {
-//         return;
-//     }
+    auto findChunk = [&](int chunkX, int chunkY, int chunkZ) -> const Chunk* {
+        return chunkGrid.find(chunkX, chunkY, chunkZ);
+    };
 
-//     unsigned int vertexOffset = meshData.vertices.size() / 6; // FIX: Stride is 6 floats per vertex
+    // nullptr when the chunk has no mesh yet, the mesh thread will pick up the edit then
+    auto editableMesh = [&](const Chunk& c, int chunkX, int chunkY, int chunkZ) -> Mesh* {
+        auto it = chunksMesh.find(hashChunkCoords(chunkX, chunkY, chunkZ));
+        if (it == chunksMesh.end()) return nullptr;
+        if (it->second.edit.active) return &it->second;
 
-//     int gx = x + chunk.position.x;
-//     int gy = y + chunk.position.y;
-//     int gz = z + chunk.position.z;
+        std::array<const Chunk*, 6> neighbors;
+        for (int i = 0; i < 6; i++) {
+            neighbors[i] = findChunk(chunkX + neighbor_map[i][0], chunkY + neighbor_map[i][1], chunkZ + neighbor_map[i][2]);
+        }
 
-//     for (int f = 0; f < 6; f++) {
-//         glm::ivec3 neighborPos = glm::ivec3(gx, gy, gz) + glm::ivec3(faceNormals[f]);
+        auto padded = std::make_unique<PaddedChunk>();
+        fillPaddedChunk(*padded, c, neighbors);
 
-//         if (isAir(neighborPos.x, neighborPos.y, neighborPos.z)) {
-//             // --- UV selection ---
-//             int ty = (id - 1) * blockTexSize; 
-//             int tx;
+        Mesh mesh = createEditableChunkMesh(*padded);
+        deleteMesh(it->second);
+        it->second = std::move(mesh);
+        return &it->second;
+    };
 
-//             if (f < 4)       tx = 0;                  // sides
-//             else if (f == 4) tx = blockTexSize * 2;    // top
-//             else             tx = blockTexSize;       // bottom
+    Mesh* mesh = editableMesh(chunk, cx, cy, cz);
+    BlockData blockData = getBlock(chunk, x, y, z);
+
+    for (int f = 0; f < 6; f++) {
+        glm::ivec3 neighbor = glm::ivec3(x, y, z) + faceNormals[f];
+
+        // neighbor can be in the next chunk along one axis
+        glm::ivec3 chunkOffset(0);
+        for (int axis = 0; axis < 3; axis++) {
+            if (neighbor[axis] < 0) {
+                chunkOffset[axis] = -1;
+                neighbor[axis] += CHUNK_SIZE;
+            } else if (neighbor[axis] >= CHUNK_SIZE) {
+                chunkOffset[axis] = 1;
+                neighbor[axis] -= CHUNK_SIZE;
+            }
+        }
 
-//             float u0 = float(tx) / atlasWidthPixels;
-//             float v0 = float(ty) / atlasHeightPixels;
-//             float u1 = float(tx + blockTexSize) / atlasWidthPixels;
-//             float v1 = float(ty + blockTexSize) / atlasHeightPixels;
+        bool sameChunk = chunkOffset == glm::ivec3(0);
+        const Chunk* neighborChunk = sameChunk ? &chunk : findChunk(cx + chunkOffset.x, cy + chunkOffset.y, cz + chunkOffset.z);
 
-//             float faceU[4] = {u0, u1, u1, u0};
-//             float faceV[4] = {v1, v1, v0, v0};
+        // missing chunks count as air, same as fillPaddedChunk
+        BlockData neighborData;
+        if (neighborChunk) {
+            neighborData = getBlock(*neighborChunk, neighbor.x, neighbor.y, neighbor.z);
+        }
 
-//             if (f == 2) { // -X face, same rotation as createChunkData
-//                 float tmpU[4] = { faceU[1], faceU[2], faceU[3], faceU[0] };
-//                 float tmpV[4] = { faceV[1], faceV[2], faceV[3], faceV[0] };
-//                 memcpy(faceU, tmpU, sizeof(faceU));
-//                 memcpy(faceV, tmpV, sizeof(faceV));
-//             }
+        if (mesh) {
+            setBlockFace(*mesh, x, y, z, f, blockData, blockData.id != 0 && neighborData.id == 0);
+        }
 
-            
-//             uint8_t light = 255;
+        // an air neighbor has no face looking at the block, its chunk mesh stays as it is
+        if (!neighborChunk || neighborData.id == 0) continue;
 
-//             for (int vert = 0; vert < 4; ++vert) {
-//                 Vertex v;
-//                 v.pos = glm::vec3(x + faceVerts[f][vert].x,
-//                                 y + faceVerts[f][vert].y,
-//                                 z + faceVerts[f][vert].z);
-//                 v.texCoord = glm::vec2(faceU[vert], faceV[vert]);
-//                 v.light = light;
-//                 meshData.vertices.push_back(v);
-//             }
+        Mesh* neighborMesh = sameChunk ? mesh : editableMesh(*neighborChunk, cx + chunkOffset.x, cy + chunkOffset.y, cz + chunkOffset.z);
+        if (neighborMesh) {
+            // opposite face has the index with the last bit flipped
+            setBlockFace(*neighborMesh, neighbor.x, neighbor.y, neighbor.z, f ^ 1, neighborData, neighborData.id != 0 && blockData.id == 0);
+        }
+    }
+}
+
+// makes face f of block x y z match visible, writes only that quad to the gpu
+void MeshSystem::setBlockFace(Mesh& mesh, int x, int y, int z, int f, const BlockData& blockData, bool visible) {
+    uint32_t key = linearBlockIndex(x, y, z) * 6 + f;
+    auto it = mesh.edit.faceSlots.find(key);
+
+    ChunkVertex quad[4] = {};
+    uint32_t slot;
+
+    if (visible) {
+        ChunkMeshData face;
+        addQuad(face, glm::ivec3(x, y, z), glm::ivec3(1), f, blockData);
+        std::memcpy(quad, face.vertices.data(), sizeof(quad));
+
+        if (it != mesh.edit.faceSlots.end()) {
+            slot = it->second; // block could have changed id or rotation
+        } else {
+            slot = allocateFaceSlot(mesh);
+            mesh.edit.faceSlots[key] = slot;
+        }
+    } else {
+        if (it == mesh.edit.faceSlots.end()) return;
+
+        slot = it->second;
+        mesh.edit.faceSlots.erase(it);
+        mesh.edit.freeSlots.push_back(slot);
+    }
+
+    std::memcpy(&mesh.data.vertices[slot * 4], quad, sizeof(quad));
+    mesh.edit.lastEdit = std::chrono::steady_clock::now();
+    mesh.edit.consolidating = false;
+
+    glBindBuffer(GL_ARRAY_BUFFER, mesh.VBO);
+    glBufferSubData(GL_ARRAY_BUFFER, slot * 4 * sizeof(ChunkVertex), sizeof(quad), quad);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
 
-//             meshData.indices.push_back(vertexOffset + 0);
-//             meshData.indices.push_back(vertexOffset + 2);
-//             meshData.indices.push_back(vertexOffset + 1);
-//             meshData.indices.push_back(vertexOffset + 0);
-//             meshData.indices.push_back(vertexOffset + 3);
-//             meshData.indices.push_back(vertexOffset + 2);
-
-//             vertexOffset += 4;
-//         }
-//     }
-
-//     updateChunkMesh(mesh); // push updated vertices/indices to GPU
-// }
+uint32_t MeshSystem::allocateFaceSlot(Mesh& mesh) {
+    MeshEditState& edit = mesh.edit;
 
+    if (!edit.freeSlots.empty()) {
+        uint32_t slot = edit.freeSlots.back();
+        edit.freeSlots.pop_back();
+        return slot;
+    }
 
+    if (edit.quadCount == edit.quadCapacity) {
+        resizeEditableMesh(mesh, edit.quadCapacity * 2);
+    }
 
-// void MeshSystem::updateChunkMesh(Mesh& chunkMesh) {
-//     glBindBuffer(GL_ARRAY_BUFFER, chunkMesh.VBO);
-//     glBufferData(GL_ARRAY_BUFFER, chunkMesh.data.vertices.size() * sizeof(float), chunkMesh.data.vertices.data(), GL_STATIC_DRAW);
+    mesh.indexCount = (edit.quadCount + 1) * 6;
+    return edit.quadCount++;
+}
 
-//     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, chunkMesh.EBO);
-//     glBufferData(GL_ELEMENT_ARRAY_BUFFER, chunkMesh.data.indices.size() * sizeof(unsigned int), chunkMesh.data.indices.data(), GL_STATIC_DRAW);
+// reallocates the buffers from the retained copy, only when every slot is taken
+void MeshSystem::resizeEditableMesh(Mesh& mesh, uint32_t quadCapacity) {
+    MeshEditState& edit = mesh.edit;
 
-//     glBindBuffer(GL_ARRAY_BUFFER, 0);
-//     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    mesh.data.vertices.resize(quadCapacity * 4, ChunkVertex{});
+    edit.quadCapacity = quadCapacity;
 
-//     chunkMesh.indexCount = chunkMesh.data.indices.size();
-// }
+    glBindVertexArray(mesh.VAO);
 
+    glBindBuffer(GL_ARRAY_BUFFER, mesh.VBO);
+    glBufferData(GL_ARRAY_BUFFER, mesh.data.vertices.size() * sizeof(ChunkVertex), mesh.data.vertices.data(), GL_STATIC_DRAW);
+
+    bindQuadIndexBuffer(mesh, quadCapacity); // switches to 32 bit once the mesh outgrows 16 bit
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    cpuMeshBytes -= mesh.cpuBytes;
+    gpuMeshBytes -= mesh.gpuBytes;
+    mesh.cpuBytes = mesh.data.vertices.capacity() * sizeof(ChunkVertex);
+    mesh.gpuBytes = mesh.data.vertices.size() * sizeof(ChunkVertex);
+    cpuMeshBytes += mesh.cpuBytes;
+    gpuMeshBytes += mesh.gpuBytes;
+}
 
 void MeshSystem::deleteMesh(const Mesh& mesh) {
+    cpuMeshBytes -= mesh.cpuBytes;
+    gpuMeshBytes -= mesh.gpuBytes;
+
     glDeleteBuffers(1, &mesh.VBO);
-    glDeleteBuffers(1, &mesh.EBO);
+    glDeleteBuffers(1, &mesh.EBO); // 0 for chunk meshes, ignored by GL
     glDeleteVertexArrays(1, &mesh.VAO);
 }
\ No newline at end of file
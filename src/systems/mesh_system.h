@@ -5,7 +5,9 @@
 #include <array>
 #include <memory>
 #include <unordered_map>
+#include <chrono>
 #include "../world/chunk.h"
+#include "../world/chunk_grid.h"
 #include <shared_mutex>
 
 struct Vertex {
@@ -20,13 +22,93 @@ struct MeshData {
     std::vector<unsigned int> indices;
 };
 
+// chunk vertex, position is local to the chunk (0-16) and the chunk origin is a per draw uniform
+// data: x 5 bits | y 5 bits | z 5 bits | face 3 bits | uv rotation 1 bit | light 8 bits
+// tile: atlas column 2 bits | atlas row
+struct ChunkVertex {
+    uint32_t data;
+    uint16_t tile;
+    uint16_t pad;
+};
+static_assert(sizeof(ChunkVertex) == 8, "ChunkVertex should stay 8 bytes");
+
+inline ChunkVertex packChunkVertex(int x, int y, int z, int face, int uvRotation, uint8_t light, int tileColumn, int tileRow) {
+    ChunkVertex v;
+    v.data = x | (y << 5) | (z << 10) | (face << 15) | (uvRotation << 18) | (light << 19);
+    v.tile = tileColumn | (tileRow << 2);
+    v.pad = 0;
+    return v;
+}
+
+// 4 vertices per quad, indices come from the shared quad index buffer
+struct ChunkMeshData {
+    std::vector<ChunkVertex> vertices;
+    int lod = 1; // block size the mesh was built with (1, 2 or 4)
+    uint8_t airBorders = 0; // bit i - neighbor i (neighbor_map order) was meshed as air, LOD seams
+    uint32_t editGeneration = 0; // Chunk::editGeneration when the snapshot was taken, older results get dropped
+    std::array<uint32_t, 6> neighborGenerations = {}; // same for the neighbors (neighbor_map order, 0 if missing)
+};
+
+enum class MeshResidency {
+    GpuOnly, // cpu copy is freed after upload
+    Retained // keeps vertices in ram (edited chunks, debug tools)
+};
+
+// face slots of an edited chunk mesh (one quad per block face), lets an edit swap single faces in place
+struct MeshEditState {
+    bool active = false;
+    std::unordered_map<uint32_t, uint32_t> faceSlots; // block index * 6 + face -> quad slot
+    std::vector<uint32_t> freeSlots; // slots holding a degenerate quad
+    uint32_t quadCount = 0;          // slots handed out so far, free ones are drawn too (as nothing)
+    uint32_t quadCapacity = 0;       // slots the gpu buffers have room for
+
+    // once edits settle the chunk is meshed normally again (merged quads, LOD, no cpu copy)
+    std::chrono::steady_clock::time_point lastEdit;
+    bool consolidating = false; // that remesh is queued, the next edit or a dropped result clears it
+};
+
 struct Mesh {
-    unsigned int VAO, VBO, EBO;
+    unsigned int VAO, VBO, EBO; // EBO is 0 for chunk meshes, they use the shared quad index buffer
     size_t indexCount;
+    GLenum indexType = GL_UNSIGNED_INT;
+
+    glm::vec3 startPositonOfChunk; // for frustum and chunkOrigin uniform
+    int lod = 1;
+    uint8_t airBorders = 0;
+    // last LOD remesh asked for, it's queued once and not every frame until the new mesh comes back
+    int requestedLod = 0;
+    uint8_t requestedAirBorders = 0;
 
-    glm::vec3 startPositonOfChunk; // for frustum
+    MeshResidency residency = MeshResidency::GpuOnly;
+    ChunkMeshData data; // only filled for Retained chunk meshes
 
-    MeshData data;
+    size_t cpuBytes = 0;
+    size_t gpuBytes = 0;
+
+    MeshEditState edit;
+};
+
+// quads a 16 bit index can address (65536 vertices)
+static constexpr uint32_t MAX_QUADS_16BIT = 65536 / 4;
+
+static constexpr int PADDED_CHUNK_SIZE = CHUNK_SIZE + 2;
+
+// mesher input, chunk blocks with a one block border copied from the 6 neighbors (missing neighbors stay air)
+// built once per mesh job so the mesher doesnt touch the chunk grid or neighbor chunks while it runs
+struct PaddedChunk {
+    glm::vec3 position;
+    BlockData blocks[PADDED_CHUNK_SIZE * PADDED_CHUNK_SIZE * PADDED_CHUNK_SIZE] = {};
+};
+
+// local chunk coords, -1 and CHUNK_SIZE are the neighbor border
+inline int getPaddedIndex(int x, int y, int z) {
+    return (x + 1) + (y + 1) * PADDED_CHUNK_SIZE + (z + 1) * PADDED_CHUNK_SIZE * PADDED_CHUNK_SIZE;
+}
+
+enum class MeshingMode {
+    PerFace, // one quad per visible face, kept as reference
+    Greedy,  // merges coplanar faces with same block id and rotation
+    Binary   // same quads as Greedy, faces found with bitmasks over whole rows
 };
 
 class MeshSystem {
@@ -35,12 +117,37 @@ public:
     const int atlasHeightPixels = 1048;
     const int blockTexSize = 32;
 
+    MeshingMode meshingMode = MeshingMode::Binary;
+    MeshResidency chunkMeshResidency = MeshResidency::GpuOnly;
+
+    // bytes held by meshes that are alive, only touched on the main (GL) thread
+    size_t cpuMeshBytes = 0;
+    size_t gpuMeshBytes = 0;
+
     Mesh createMesh(MeshData& meshData);
+    Mesh createChunkMesh(ChunkMeshData& meshData);
+    Mesh createChunkMesh(ChunkMeshData& meshData, MeshResidency residency);
     void deleteMesh(const Mesh& mesh);
-    MeshData createChunkData(const Chunk& chunk, const std::array<std::shared_ptr<Chunk>, 6>& neighbors, int LOD = 1);
-    void updateMeshDataWithBlock(Mesh& mesh, const Chunk& chunk, const std::unordered_map<uint64_t, std::shared_ptr<Chunk>>& chunkMap, int x, int y, int z);
-    void updateChunkMesh(Mesh& chunkMesh);
+    void deleteQuadIndexBuffers();
+    void fillPaddedChunk(PaddedChunk& padded, const Chunk& chunk, const std::array<const Chunk*, 6>& neighbors);
+    static bool isChunkHidden(const Chunk& chunk, const std::array<const Chunk*, 6>& neighbors);
+    ChunkMeshData createChunkData(const PaddedChunk& chunk, int LOD = 1);
+    void downsamplePaddedChunk(PaddedChunk& chunk, int LOD);
+    ChunkMeshData createChunkDataPerFace(const PaddedChunk& chunk);
+    ChunkMeshData createChunkDataGreedy(const PaddedChunk& chunk);
+    ChunkMeshData createChunkDataBinary(const PaddedChunk& chunk);
+    Mesh createEditableChunkMesh(const PaddedChunk& chunk);
+    void updateMeshDataWithBlock(std::unordered_map<uint64_t, Mesh>& chunksMesh, const ChunkGrid& chunkGrid, const Chunk& chunk, int x, int y, int z);
 
 private:
-    void rotateUV(glm::vec2 uvs[4], int rotation);
+    void addQuad(ChunkMeshData& data, const glm::ivec3& origin, const glm::ivec3& size, int f, const BlockData& blockData);
+    void setBlockFace(Mesh& mesh, int x, int y, int z, int f, const BlockData& blockData, bool visible);
+    uint32_t allocateFaceSlot(Mesh& mesh);
+    void resizeEditableMesh(Mesh& mesh, uint32_t quadCapacity);
+    void bindQuadIndexBuffer(Mesh& mesh, uint32_t quadCount);
+
+    // 0,2,1,0,3,2 + 4 * quad for every quad, shared by all chunk VAOs
+    unsigned int quadIndexBuffer16 = 0; // always MAX_QUADS_16BIT quads
+    unsigned int quadIndexBuffer32 = 0; // made on demand for bigger meshes, grows
+    uint32_t quadIndexCapacity32 = 0;
 };
\ No newline at end of file
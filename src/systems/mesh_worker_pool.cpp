@@ -0,0 +1,86 @@
+#include "mesh_worker_pool.h"
+#include <algorithm>
+
+MeshWorkerPool::MeshWorkerPool(int workerCount) {
+    if (workerCount <= 0) {
+        workerCount = std::max(1, static_cast<int>(std::thread::hardware_concurrency()) - 2);
+    }
+
+    for (int i = 0; i < workerCount; i++) {
+        queues.push_back(std::make_unique<WorkerQueue>());
+    }
+
+    for (int i = 0; i < workerCount; i++) {
+        workers.emplace_back([this, i]() { workerLoop(i); });
+    }
+}
+
+MeshWorkerPool::~MeshWorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        running = false;
+    }
+    wake.notify_all();
+
+    for (auto& worker : workers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+}
+
+void MeshWorkerPool::submit(std::vector<std::function<void()>>& jobs) {
+    if (jobs.empty()) return;
+
+    {
+        // counted before the push so pending never drops below zero, under the wake mutex so a worker cant miss it
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        pending += jobs.size();
+    }
+
+    for (auto& job : jobs) {
+        WorkerQueue& queue = *queues[nextQueue];
+        nextQueue = (nextQueue + 1) % queues.size();
+
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.jobs.push_back(std::move(job));
+    }
+    jobs.clear();
+
+    wake.notify_all();
+}
+
+// own queue from the front (nearest), others from the back
+bool MeshWorkerPool::popJob(int index, std::function<void()>& job) {
+    for (size_t i = 0; i < queues.size(); i++) {
+        WorkerQueue& queue = *queues[(index + i) % queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.jobs.empty()) continue;
+
+        if (i == 0) {
+            job = std::move(queue.jobs.front());
+            queue.jobs.pop_front();
+        } else {
+            job = std::move(queue.jobs.back());
+            queue.jobs.pop_back();
+        }
+
+        pending--;
+        return true;
+    }
+
+    return false;
+}
+
+void MeshWorkerPool::workerLoop(int index) {
+    while (running) {
+        std::function<void()> job;
+        if (popJob(index, job)) {
+            job();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(wakeMutex);
+        wake.wait(lock, [this]() { return !running || pending > 0; });
+    }
+}
\ No newline at end of file
@@ -0,0 +1,41 @@
+#pragma once
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+// meshing threads, every worker has its own deque and steals from the others when it runs dry
+class MeshWorkerPool {
+public:
+    // workerCount <= 0 - hardware threads minus the main and generation thread
+    MeshWorkerPool(int workerCount);
+    ~MeshWorkerPool();
+
+    // jobs should be sorted nearest first, they're dealt round robin so every worker starts near the player
+    void submit(std::vector<std::function<void()>>& jobs);
+
+    size_t queueDepth() const { return pending.load(); }
+    int workerCount() const { return static_cast<int>(workers.size()); }
+
+private:
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> jobs;
+    };
+
+    void workerLoop(int index);
+    bool popJob(int index, std::function<void()>& job);
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    std::vector<std::thread> workers;
+
+    std::mutex wakeMutex;
+    std::condition_variable wake;
+    std::atomic<size_t> pending{0}; // submitted jobs no worker has picked up yet
+    std::atomic<bool> running{true};
+    size_t nextQueue = 0;
+};
\ No newline at end of file
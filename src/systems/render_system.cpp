@@ -7,6 +7,7 @@
 #define STB_TRUETYPE_IMPLEMENTATION
 #include <stb/stb_truetype.h>
 #include <thread>
+#include <algorithm>
 #include <../utilities/raycast.h>
 
 #include <glm/gtc/matrix_transform.hpp>
@@ -54,17 +55,57 @@ RenderSystem::RenderSystem(unsigned int shaders[], GLFWwindow* window, World* w,
         }
     });
 
+    meshWorkers = std::make_unique<MeshWorkerPool>(MESH_WORKER_COUNT);
+
     meshCreationThread = std::thread([this]() {
         while (runningCreationThread) {
-            generate_world_meshes();
-            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            // comes back sooner while there is work so the workers dont run dry
+            bool submitted = generate_world_meshes();
+            std::this_thread::sleep_for(std::chrono::milliseconds(submitted ? 1 : 10));
         }
     });
 }
     
+// mesh detail for a chunk from its chebyshev distance to the player chunk
+static int chunkLOD(int cx, int cy, int cz, int playerChunkX, int playerChunkY, int playerChunkZ) {
+    int distance = std::max({abs(cx - playerChunkX), abs(cy - playerChunkY), abs(cz - playerChunkZ)});
+
+    if (distance >= LOD4_DISTANCE) return 4;
+    if (distance >= LOD2_DISTANCE) return 2;
+    return 1;
+}
+
+const int neighborOffsets[6][3] = {
+    {1, 0, 0}, {-1, 0, 0},
+    {0, 1, 0}, {0, -1, 0},
+    {0, 0, 1}, {0, 0, -1}
+};
+
+// neighbors meshed as air (bit per neighborOffsets entry): every face where one side is downsampled
+// a downsampled chunk doesn't draw what its full blocks would, so culling against them leaves holes,
+// with both sides drawing their faces there the seam is closed
+static uint8_t lodAirBorders(int cx, int cy, int cz, int playerChunkX, int playerChunkY, int playerChunkZ) {
+    bool downsampled = chunkLOD(cx, cy, cz, playerChunkX, playerChunkY, playerChunkZ) > 1;
+
+    uint8_t airBorders = 0;
+    for (int i = 0; i < 6; i++) {
+        int nx = cx + neighborOffsets[i][0];
+        int ny = cy + neighborOffsets[i][1];
+        int nz = cz + neighborOffsets[i][2];
+        if (downsampled || chunkLOD(nx, ny, nz, playerChunkX, playerChunkY, playerChunkZ) > 1) {
+            airBorders |= 1 << i;
+        }
+    }
+    return airBorders;
+}
+
 bool wireframe = false;
 bool wireframeClicked = true;
 void RenderSystem::update(std::unordered_map<unsigned int, TransformComponent> &transformComponents, std::unordered_map<unsigned int, RenderComponent> &renderComponents, CameraComponent& cameraComponent) {
+    // chunks unloaded since the readers that could see them left, this thread isn't reading any right now
+    world->epochs.collect();
+    EpochGuard epoch(world->epochs);
+
     int width, height;
     glfwGetFramebufferSize(window, &width, &height);
 
@@ -90,10 +131,6 @@ void RenderSystem::update(std::unordered_map<unsigned int, TransformComponent> &
 
     processMeshQueue(); 
 
-    glm::mat4 model = glm::mat4(1.0f);
-    unsigned int modelLocation = glGetUniformLocation(shader, "model");
-    glUniformMatrix4fv(modelLocation, 1, GL_FALSE, glm::value_ptr(model));
-
     if(wireframe){
         glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
     }
@@ -101,19 +138,71 @@ void RenderSystem::update(std::unordered_map<unsigned int, TransformComponent> &
     float aspect = static_cast<float>(width) / static_cast<float>(height);
 	glm::mat4 projection = glm::perspective(App::fov, aspect, 0.01f, 1000.0f);
 
+    glUniform2f(glGetUniformLocation(shader, "tileSize"), meshSystem.blockTexSize / static_cast<float>(meshSystem.atlasWidthPixels), meshSystem.blockTexSize / static_cast<float>(meshSystem.atlasHeightPixels));
+    unsigned int chunkOriginLocation = glGetUniformLocation(shader, "chunkOrigin");
+
+    glm::vec3 playerPos = transformComponents[App::cameraID].position;
+    int playerChunkX = static_cast<int>(floor(playerPos.x / CHUNK_SIZE));
+    int playerChunkY = static_cast<int>(floor(playerPos.y / CHUNK_SIZE));
+    int playerChunkZ = static_cast<int>(floor(playerPos.z / CHUNK_SIZE));
+    std::vector<uint64_t> remeshes;
+    auto now = std::chrono::steady_clock::now();
+
     Frustum frustum = extractFrustum(projection * cameraComponent.viewMatrix);
     for (auto& pair : chunksMesh) {
         Mesh& mesh = pair.second;
 
+        int cx, cy, cz;
+        decodeChunkHash(pair.first, cx, cy, cz);
+        // edited meshes are patched in place and keep full detail until edits settle, then they're meshed normally again
+        if (mesh.edit.active) {
+            if (!mesh.edit.consolidating && now - mesh.edit.lastEdit >= std::chrono::milliseconds(MESH_CONSOLIDATE_DELAY_MS)) {
+                mesh.edit.consolidating = true;
+                remeshes.push_back(pair.first);
+            }
+        } else {
+            int lod = chunkLOD(cx, cy, cz, playerChunkX, playerChunkY, playerChunkZ);
+            uint8_t airBorders = lodAirBorders(cx, cy, cz, playerChunkX, playerChunkY, playerChunkZ);
+            bool changed = lod != mesh.lod || airBorders != mesh.airBorders;
+            bool requested = lod == mesh.requestedLod && airBorders == mesh.requestedAirBorders;
+            if (changed && !requested) {
+                mesh.requestedLod = lod;
+                mesh.requestedAirBorders = airBorders;
+                remeshes.push_back(pair.first);
+            }
+        }
+
+        if (mesh.indexCount == 0) continue;
+
         if(isBoxInFrustum(frustum, mesh.startPositonOfChunk, mesh.startPositonOfChunk + glm::vec3(CHUNK_SIZE))){
+            glUniform3f(chunkOriginLocation, mesh.startPositonOfChunk.x, mesh.startPositonOfChunk.y, mesh.startPositonOfChunk.z);
             glBindVertexArray(mesh.VAO);
             glBindTexture(GL_TEXTURE_2D, blocksTextureID);
-            glDrawElements(GL_TRIANGLES, mesh.indexCount, GL_UNSIGNED_INT, 0);
+            glDrawElements(GL_TRIANGLES, mesh.indexCount, mesh.indexType, 0);
         }
     }
     
     glPolygonMode(GL_FRONT, GL_FILL);
 
+    // chunks that crossed a LOD ring (or next to one that did) and settled edited chunks get remeshed,
+    // the old mesh stays drawn until the new one is uploaded
+    if (!remeshes.empty()) {
+        std::scoped_lock lock(meshCreationQueueMutex);
+        for (uint64_t hash : remeshes) {
+            if (world->chunkGrid.find(hash)) {
+                meshCreationQueue.insert(hash);
+            }
+        }
+    }
+
+    // world shader only reads packed chunk vertices, entities and the hover block use the 3d hud shader in world space
+    glUseProgram(shader3D_hud);
+    glUniformMatrix4fv(glGetUniformLocation(shader3D_hud, "view"), 1, GL_FALSE, glm::value_ptr(cameraComponent.viewMatrix));
+    glUniformMatrix4fv(glGetUniformLocation(shader3D_hud, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+    glUniform2f(glGetUniformLocation(shader3D_hud, "tileSize"), 1.0f, 1.0f);
+    glUniform2f(glGetUniformLocation(shader3D_hud, "tileOffset"), 0.0f, 0.0f);
+    unsigned int modelLocation = glGetUniformLocation(shader3D_hud, "model");
+
     // rendering entites
     for (auto& entity : renderComponents) {
         TransformComponent& transform = transformComponents[entity.first];
@@ -139,13 +228,35 @@ void RenderSystem::update(std::unordered_map<unsigned int, TransformComponent> &
     cameraDir.z = -cos(pitch) * cos(yaw);
     cameraDir = glm::normalize(cameraDir);
 
+    glm::mat4 model = glm::mat4(1.0f);
+    glUniformMatrix4fv(modelLocation, 1, GL_FALSE, glm::value_ptr(model));
     renderHoverBlock(transformComponents[App::cameraID].position, cameraDir, 0);
 
+    glUseProgram(shader);
+
     std::string coordinates = "X: " + std::to_string((int)transformComponents[App::cameraID].position.x) + 
                               " Y: " + std::to_string((int)transformComponents[App::cameraID].position.y) + 
                               " Z: " + std::to_string((int)transformComponents[App::cameraID].position.z);
     drawText(coordinates, 5.0f, 0.0f, 1.0f, glm::vec4(1.0f, 1.0f, 1.0f, 1.0f));
     drawText(std::to_string(App::fps), 5.0f, fontHeight, 1.0f, glm::vec4(1.0f, 1.0f, 1.0f, 1.0f));
+
+    std::string meshMemory = "Mesh RAM: " + std::to_string(meshSystem.cpuMeshBytes / 1024) + " KB" +
+                             " VRAM: " + std::to_string(meshSystem.gpuMeshBytes / 1024) + " KB";
+    drawText(meshMemory, 5.0f, fontHeight * 2, 1.0f, glm::vec4(1.0f, 1.0f, 1.0f, 1.0f));
+
+    std::string meshJobs = "Mesh queue: " + std::to_string(meshWorkers->queueDepth()) +
+                           " Workers: " + std::to_string(meshWorkers->workerCount());
+    drawText(meshJobs, 5.0f, fontHeight * 3, 1.0f, glm::vec4(1.0f, 1.0f, 1.0f, 1.0f));
+
+    std::string saveQueue = "Save queue: " + std::to_string(world->writer.backlog());
+    drawText(saveQueue, 5.0f, fontHeight * 4, 1.0f, glm::vec4(1.0f, 1.0f, 1.0f, 1.0f));
+
+    ChunkPool::Stats poolStats = world->chunkPool.getStats();
+    std::string chunkPool = "Chunks: " + std::to_string(poolStats.inUse) +
+                            " Pool free: " + std::to_string(poolStats.free) +
+                            " Reused: " + std::to_string(poolStats.reused) +
+                            " Allocated: " + std::to_string(poolStats.allocated);
+    drawText(chunkPool, 5.0f, fontHeight * 5, 1.0f, glm::vec4(1.0f, 1.0f, 1.0f, 1.0f));
     
     drawHandItem(transformComponents);
     drawHotbar();
@@ -177,9 +288,52 @@ void RenderSystem::update(std::unordered_map<unsigned int, TransformComponent> &
 }
 
 void RenderSystem::processMeshQueue() {
-    std::lock_guard<std::mutex> meshLock(meshQueueMutex);
-    for (auto& [hash, meshData] : meshQueue) {
-        Mesh mesh = meshSystem.createMesh(meshData);
+    // taken out first, workers keep pushing results meanwhile
+    std::vector<std::pair<uint64_t, ChunkMeshData>> finished;
+    {
+        std::lock_guard<std::mutex> meshLock(meshQueueMutex);
+        finished.swap(meshQueue);
+    }
+
+    // edits only happen on this thread, so what's checked here still holds when the meshes are made below
+    std::vector<uint64_t> remesh;
+    {
+        std::shared_lock chunkLock(world->chunkGridMutex);
+        finished.erase(std::remove_if(finished.begin(), finished.end(), [&](const std::pair<uint64_t, ChunkMeshData>& result) {
+            // unloaded while it was meshed
+            const Chunk* chunk = world->chunkGrid.find(result.first);
+            if (!chunk) return true;
+
+            auto it = chunksMesh.find(result.first);
+            bool patched = it != chunksMesh.end() && it->second.edit.active;
+
+            // edits are patched into the live mesh, a result from before them would undo the edit on screen
+            bool stale = result.second.editGeneration != chunk->editGeneration;
+
+            // a patched mesh also has the faces edits next door changed on its border, the result has to include those too
+            if (patched && !stale) {
+                int cx, cy, cz;
+                decodeChunkHash(result.first, cx, cy, cz);
+                for (int i = 0; i < 6; i++) {
+                    const Chunk* neighbor = world->chunkGrid.find(cx + neighborOffsets[i][0], cy + neighborOffsets[i][1], cz + neighborOffsets[i][2]);
+                    stale |= (neighbor ? neighbor->editGeneration.load() : 0) != result.second.neighborGenerations[i];
+                }
+            }
+
+            if (stale) {
+                if (patched) {
+                    it->second.edit.consolidating = false; // queued again once the delay is up
+                } else {
+                    remesh.push_back(result.first); // edited before it had a mesh, nothing shows the edit yet
+                }
+                return true;
+            }
+            return false;
+        }), finished.end());
+    }
+
+    for (auto& [hash, meshData] : finished) {
+        Mesh mesh = meshSystem.createChunkMesh(meshData);
 
         int x, y, z;
         decodeChunkHash(hash, x, y, z);
@@ -188,9 +342,18 @@ void RenderSystem::processMeshQueue() {
         z *= CHUNK_SIZE;
 
         mesh.startPositonOfChunk = {x, y, z};
+
+        auto it = chunksMesh.find(hash);
+        if (it != chunksMesh.end()) {
+            meshSystem.deleteMesh(it->second);
+        }
         chunksMesh[hash] = std::move(mesh);
     }
-    meshQueue.clear();
+
+    if (!remesh.empty()) {
+        std::unique_lock lock(meshCreationQueueMutex);
+        meshCreationQueue.insert(remesh.begin(), remesh.end());
+    }
 
     std::lock_guard<std::mutex> deletionLock(meshDeleteQueueMutex);
     for (uint64_t hash : chunksToDeleteQueue) {
@@ -231,7 +394,7 @@ void RenderSystem::processChunkGeneration() {
     int cx, cy, cz;
     decodeChunkHash(hash_to_process, cx, cy, cz);
 
-    auto chunk = std::make_shared<Chunk>();
+    auto chunk = world->chunkPool.acquire();
     chunk->position = {
         static_cast<float>(cx * CHUNK_SIZE),
         static_cast<float>(cy * CHUNK_SIZE),
@@ -245,17 +408,18 @@ void RenderSystem::processChunkGeneration() {
         world->loadedChunks.insert(hash_to_process);
     }
     {
-        std::unique_lock lock(world->chunkMapMutex);
-        world->chunkMap.emplace(hash_to_process, chunk);
+        std::unique_lock lock(world->chunkGridMutex);
+        // already loaded, the chunk goes straight back to the pool
+        if (!world->chunkGrid.insert(hash_to_process, chunk)) return;
     }
     {
         std::scoped_lock lock(meshCreationQueueMutex);
-        meshCreationQueue.emplace(hash_to_process, chunk);
+        meshCreationQueue.insert(hash_to_process);
     }
 }
 
 void RenderSystem::generate_world(const glm::vec3& playerPos) {
-    auto& chunkMap = world->chunkMap;
+    auto& chunkGrid = world->chunkGrid;
 
     int playerChunkX = static_cast<int>(floor(playerPos.x / CHUNK_SIZE));
     int playerChunkY = static_cast<int>(floor(playerPos.y / CHUNK_SIZE));
@@ -279,25 +443,34 @@ void RenderSystem::generate_world(const glm::vec3& playerPos) {
     std::vector<uint64_t> new_chunks_to_generate;
     // --- 1. Unload distant chunks ---
     {
-        std::unique_lock lock(world->chunkMapMutex);
-        for (auto it = chunkMap.begin(); it != chunkMap.end(); ) {
+        std::unique_lock lock(world->chunkGridMutex);
+        std::vector<uint64_t> unloaded;
+        chunkGrid.forEach([&](uint64_t hash, Chunk& chunk) {
             int cx, cy, cz;
-            decodeChunkHash(it->first, cx, cy, cz);
+            decodeChunkHash(hash, cx, cy, cz);
 
             if (abs(cx - playerChunkX) > load_dist_h || abs(cy - playerChunkY) > load_dist_v || abs(cz - playerChunkZ) > load_dist_h) {
-                {
-                    std::lock_guard<std::mutex> lock(meshDeleteQueueMutex);
-                    chunksToDeleteQueue.push_back(it->first);
-                }
-
-                writeChunkToFile(*(it->second), world->seed);
-                it = chunkMap.erase(it);
-            } else {
-                ++it;
+                // queued while still in the grid, so a save of the world that can't see the chunk anymore
+                // can't finish (and empty the edit journal) before the chunk's edits are queued
+                world->writer.save(chunk);
+                unloaded.push_back(hash);
             }
+        });
+
+        if (!unloaded.empty()) {
+            std::lock_guard<std::mutex> deleteLock(meshDeleteQueueMutex);
+            chunksToDeleteQueue.insert(chunksToDeleteQueue.end(), unloaded.begin(), unloaded.end());
+        }
+
+        // retired, back to the pool once no thread can still be reading them
+        for (uint64_t hash : unloaded) {
+            chunkGrid.remove(hash);
         }
     }
 
+    // columns of the unloaded chunks, the ones still in range stay for the chunks queued below
+    world->columnCache.evictOutside(playerChunkX, playerChunkZ, load_dist_h);
+
     // --- 2. Discover new chunks to load ---
     for (int dx = -load_dist_h; dx <= load_dist_h; ++dx) {
         for (int dz = -load_dist_h; dz <= load_dist_h; ++dz) {
@@ -307,13 +480,8 @@ void RenderSystem::generate_world(const glm::vec3& playerPos) {
                 int cz = playerChunkZ + dz;
                 uint64_t hash = hashChunkCoords(cx, cy, cz);
 
-                bool chunk_exists;
-                {
-                    std::shared_lock lock(world->chunkMapMutex);
-                    chunk_exists = (chunkMap.count(hash) > 0);
-                }
-
-                if (!chunk_exists) {
+                // only this thread adds or removes chunks, no lock needed
+                if (!chunkGrid.find(hash)) {
                     new_chunks_to_generate.push_back(hash);
                 }
             }
@@ -337,69 +505,164 @@ void RenderSystem::generate_world(const glm::vec3& playerPos) {
     }
 }
 
+// picks ready chunks nearest first and tops up the worker queues, the rest waits in meshCreationQueue
+// so the order can still follow the player
+bool RenderSystem::generate_world_meshes() {
+    size_t maxQueued = meshWorkers->workerCount() * 16;
+    size_t queued = meshWorkers->queueDepth();
+    if (queued >= maxQueued) {
+        return true;
+    }
 
-const int neighborOffsets[6][3] = {
-    {1, 0, 0}, {-1, 0, 0},
-    {0, 1, 0}, {0, -1, 0},
-    {0, 0, 1}, {0, 0, -1}
-};
-
-void RenderSystem::generate_world_meshes() {
-    std::vector<std::pair<uint64_t, std::shared_ptr<Chunk>>> ready_to_mesh;
+    std::vector<uint64_t> ready_to_mesh;
 
     {
         std::shared_lock lock(meshCreationQueueMutex);
         if (meshCreationQueue.empty()) {
-            return;
+            return false;
         }
 
         // faster locking
         ready_to_mesh.reserve(meshCreationQueue.size());
-        for (const auto& pair : meshCreationQueue) {
+        for (uint64_t hash : meshCreationQueue) {
+            // one job per chunk at a time, the remesh waits here so its result can't be beaten by the older one
+            if (meshesInFlight.count(hash)) continue;
+
             bool is_ready;
             {
                 std::shared_lock loaded_lock(world->loadedChunksMutex);
-                is_ready = neighborsReady(pair.first, world->loadedChunks);
+                is_ready = neighborsReady(hash, world->loadedChunks);
             }
             if (is_ready) {
-                ready_to_mesh.push_back(pair);
+                ready_to_mesh.push_back(hash);
             }
         }
     }
 
     if (ready_to_mesh.empty()) {
-        return;
+        return false;
     }
 
-    for (const auto& pair : ready_to_mesh) {
-        const auto& hash = pair.first;
-        const auto& chunkToMesh = pair.second;
+    glm::vec3 cameraPos;
+    {
+        std::lock_guard<std::mutex> lock(cameraMutex);
+        cameraPos = cameraPosForThread;
+    }
+    int playerChunkX = static_cast<int>(floor(cameraPos.x / CHUNK_SIZE));
+    int playerChunkY = static_cast<int>(floor(cameraPos.y / CHUNK_SIZE));
+    int playerChunkZ = static_cast<int>(floor(cameraPos.z / CHUNK_SIZE));
+
+    std::sort(ready_to_mesh.begin(), ready_to_mesh.end(),
+        [&](uint64_t a, uint64_t b) {
+            int ax, ay, az, bx, by, bz;
+            decodeChunkHash(a, ax, ay, az);
+            decodeChunkHash(b, bx, by, bz);
+            return (abs(ax - playerChunkX) + abs(az - playerChunkZ) + abs(ay - playerChunkY)) <
+                   (abs(bx - playerChunkX) + abs(bz - playerChunkZ) + abs(by - playerChunkY));
+        });
+
+    if (ready_to_mesh.size() > maxQueued - queued) {
+        ready_to_mesh.resize(maxQueued - queued);
+    }
 
-        // neigbour data - locking for less time and also doesnt double lock inside chunkData creation
-        std::array<std::shared_ptr<Chunk>, 6> neighbors;
-        {
-            std::shared_lock chunkLock(world->chunkMapMutex);
-            int cx, cy, cz;
-            decodeChunkHash(hash, cx, cy, cz);
-            for (int i = 0; i < 6; ++i) {
-                uint64_t nHash = hashChunkCoords(cx + neighborOffsets[i][0], cy + neighborOffsets[i][1], cz + neighborOffsets[i][2]);
-                auto it = world->chunkMap.find(nHash);
-                neighbors[i] = (it != world->chunkMap.end()) ? it->second : nullptr;
-            }
+    // taken out before meshing, a remesh requested meanwhile stays queued
+    {
+        std::unique_lock lock(meshCreationQueueMutex);
+        for (uint64_t hash : ready_to_mesh) {
+            meshCreationQueue.erase(hash);
+            meshesInFlight.insert(hash);
         }
+    }
 
-        MeshData meshData = meshSystem.createChunkData(*chunkToMesh, neighbors);
-        
-        std::lock_guard<std::mutex> meshLock(meshQueueMutex);
-        meshQueue.push_back({hash, meshData});
+    std::vector<std::function<void()>> jobs;
+    jobs.reserve(ready_to_mesh.size());
+    for (uint64_t hash : ready_to_mesh) {
+        int cx, cy, cz;
+        decodeChunkHash(hash, cx, cy, cz);
+        int lod = chunkLOD(cx, cy, cz, playerChunkX, playerChunkY, playerChunkZ);
+        uint8_t airBorders = lodAirBorders(cx, cy, cz, playerChunkX, playerChunkY, playerChunkZ);
+
+        jobs.push_back([this, hash, lod, airBorders]() {
+            bool meshed = meshChunk(hash, lod, airBorders);
+
+            // the result is in meshQueue now, a newer job for the chunk can't push before it
+            std::unique_lock lock(meshCreationQueueMutex);
+            meshesInFlight.erase(hash);
+            if (!meshed) meshCreationQueue.insert(hash);
+        });
     }
+    meshWorkers->submit(jobs);
 
+    return true;
+}
+
+// runs on a mesh worker, false when an edit got in the way of the copy and the chunk has to be queued again
+bool RenderSystem::meshChunk(uint64_t hash, int lod, uint8_t airBorders) {
+    int cx, cy, cz;
+    decodeChunkHash(hash, cx, cy, cz);
+
+    // copy chunk and neighbour borders once without the grid lock, mesher then works only on the copy
+    // the epoch keeps the chunks alive, edit generations (odd during an edit) are read before and after the copy
+    // an edit starting meanwhile waits for this guard to go away (World::beginBlockEdit), a chunk caught mid edit is queued again
+    PaddedChunk padded;
+    bool hidden;
+    uint32_t editGeneration;
+    std::array<uint32_t, 6> neighborGenerations;
     {
-        std::unique_lock lock(meshCreationQueueMutex);
-        for (const auto& pair : ready_to_mesh) {
-            meshCreationQueue.erase(pair.first);
+        EpochGuard epoch(world->epochs);
+
+        // unloaded while it waited in the queue
+        const Chunk* chunk = world->chunkGrid.find(hash);
+        if (!chunk) return true;
+
+        // LOD seams are meshed against air, missing neighbors count as air too
+        std::array<const Chunk*, 6> found;
+        std::array<const Chunk*, 6> neighbors;
+        bool editing = false;
+        for (int i = 0; i < 6; ++i) {
+            found[i] = world->chunkGrid.find(cx + neighborOffsets[i][0], cy + neighborOffsets[i][1], cz + neighborOffsets[i][2]);
+            neighborGenerations[i] = found[i] ? found[i]->editGeneration.load(std::memory_order_acquire) : 0;
+            neighbors[i] = (airBorders >> i) & 1 ? nullptr : found[i];
+            editing |= neighborGenerations[i] & 1;
+        }
+        editGeneration = chunk->editGeneration.load(std::memory_order_acquire);
+        if (editing || (editGeneration & 1)) return false;
+
+        // sky and buried chunks, an empty mesh still replaces whatever was drawn before
+        hidden = MeshSystem::isChunkHidden(*chunk, neighbors);
+        if (!hidden) {
+            meshSystem.fillPaddedChunk(padded, *chunk, neighbors);
         }
+
+        // block reads stay before the second look at the generations
+        std::atomic_thread_fence(std::memory_order_acquire);
+        bool changed = chunk->editGeneration.load(std::memory_order_relaxed) != editGeneration;
+        for (int i = 0; i < 6; ++i) {
+            changed |= (found[i] ? found[i]->editGeneration.load(std::memory_order_relaxed) : 0) != neighborGenerations[i];
+        }
+        if (changed) return false;
+    }
+
+    if (hidden) {
+        ChunkMeshData empty;
+        empty.lod = lod;
+        empty.airBorders = airBorders;
+        empty.editGeneration = editGeneration;
+        empty.neighborGenerations = neighborGenerations;
+
+        std::lock_guard<std::mutex> meshLock(meshQueueMutex);
+        meshQueue.push_back({hash, std::move(empty)});
+        return true;
     }
+
+    ChunkMeshData meshData = meshSystem.createChunkData(padded, lod);
+    meshData.airBorders = airBorders;
+    meshData.editGeneration = editGeneration;
+    meshData.neighborGenerations = neighborGenerations;
+
+    std::lock_guard<std::mutex> meshLock(meshQueueMutex);
+    meshQueue.push_back({hash, std::move(meshData)});
+    return true;
 }
 
 bool RenderSystem::neighborsReady(uint64_t hash, const std::unordered_set<uint64_t>& loadedChunks) {
@@ -486,7 +749,7 @@ void RenderSystem::drawText(const std::string& text, float x, float y, float sca
 }
 
 void RenderSystem::renderHoverBlock(glm::vec3 playerPos, glm::vec3 cameraDir, float eyeHeight){
-    RaycastHit hit = raycast(playerPos + glm::vec3(0, eyeHeight, 0), cameraDir, 5.0f, world->chunkMap);
+    RaycastHit hit = raycast(playerPos + glm::vec3(0, eyeHeight, 0), cameraDir, 5.0f, world->chunkGrid);
 
     if (hit.hit) {
         int x = hit.block.position.x;
@@ -580,7 +843,7 @@ void RenderSystem::renderHoverBlock(glm::vec3 playerPos, glm::vec3 cameraDir, fl
         meshSystem.deleteMesh(hoverMesh);
 
         // breaking and placing blocks & middle clicking
-        logicSystem->handlePlayerMouseClick(hit, world->chunkMapMutex, meshCreationQueueMutex, meshSystem, chunksMesh);
+        logicSystem->handlePlayerMouseClick(hit, world->chunkGridMutex, meshCreationQueueMutex, meshSystem, chunksMesh);
     }
 }
 
@@ -671,12 +934,14 @@ RenderSystem::~RenderSystem() {
     if (meshCreationThread.joinable()) {
         meshCreationThread.join();
     }
+    meshWorkers.reset(); // jobs use this, stop them before anything goes away
 
     // Clean up all chunk meshes
     for (auto& pair : chunksMesh) {
         meshSystem.deleteMesh(pair.second);
     }
     chunksMesh.clear();
+    meshSystem.deleteQuadIndexBuffers();
 
     if (handItemMesh.VAO != 0) {
         meshSystem.deleteMesh(handItemMesh);
@@ -695,13 +960,48 @@ RenderSystem::~RenderSystem() {
 
 void RenderSystem::saveWorld(){
     {
-        auto& chunkMap = world->chunkMap;
+        std::shared_lock chunkLock(world->chunkGridMutex);
+        // save() skips chunks that haven't changed since they were last written
+        world->chunkGrid.forEach([this](uint64_t, Chunk& chunk) {
+            world->writer.save(chunk);
+        });
+    }
 
-        std::shared_lock chunkLock(world->chunkMapMutex);
-        for (auto& [hash, chunk] : chunkMap) {
-            writeChunkToFile(*chunk, world->seed);
-        }
+    size_t total = world->writer.backlog();
+    bool saved = world->writer.flush([total](size_t left) {
+        std::cout << "Saving world: " << total - std::min(left, total) << "/" << total << " chunks" << std::endl;
+    });
+
+    // a chunk that didn't make it to disk still has its edits in the journal only
+    if (!saved) {
+        std::cerr << "Saving world failed, keeping the edit journal" << std::endl;
+        return;
+    }
+
+    // every edit is in region storage now
+    world->journal.checkpoint();
+}
+
+// folds the edit journal into region storage without waiting for the disk, the writer thread writes and syncs
+// the journal is rotated first, edits made meanwhile go to a fresh log the rotated one's save can't drop
+void RenderSystem::autosaveWorld() {
+    // the last autosave is still being written
+    if (!world->journal.rotate()) return;
+
+    {
+        std::shared_lock chunkLock(world->chunkGridMutex);
+        world->chunkGrid.forEach([this](uint64_t, Chunk& chunk) {
+            world->writer.save(chunk);
+        });
     }
+
+    World* savedWorld = world;
+    world->writer.flushAsync([savedWorld](bool saved) {
+        if (!saved) {
+            std::cerr << "Autosave failed, keeping the edit journal" << std::endl;
+        }
+        savedWorld->journal.finishRotation(saved);
+    });
 }
 
 void RenderSystem::generate3DCubeMesh() {
@@ -18,6 +18,7 @@
 #include <future>
 #include "camera_component.h"
 #include "textureManager.h"
+#include "mesh_worker_pool.h"
 
 class LogicSystem;
 
@@ -30,7 +31,7 @@ public:
 
     void update(std::unordered_map<unsigned int,TransformComponent> &transformComponents,std::unordered_map<unsigned int,RenderComponent> &renderComponents, CameraComponent& cameraComponent);
     void generate_world(const glm::vec3& playerPos);
-    void generate_world_meshes();
+    bool generate_world_meshes();
     unsigned int make_texture(const char* filename);
     unsigned int make_texture_resized(const char* filename, float scale);
     void drawText(const std::string& text, float x, float y, float scale, const glm::vec4& color);
@@ -39,6 +40,7 @@ public:
     void drawCursor();
     void setUpBuffers();
     void saveWorld();
+    void autosaveWorld();
     void drawHandItem(std::unordered_map<unsigned int, TransformComponent>& transformComponents);
     void drawHotbar();
     void drawItem(float x, float y, float scale, int itemID);
@@ -53,7 +55,8 @@ public:
     TextureManager textureManager;
 private:
     std::thread dataCreationThread;
-    std::thread meshCreationThread;
+    std::thread meshCreationThread; // hands ready chunks to meshWorkers
+    std::unique_ptr<MeshWorkerPool> meshWorkers;
     std::atomic<bool> runningCreationThread;    
     std::vector<uint64_t> chunksToGenerate;
     glm::vec3 cameraPosForThread; // Shared camera position for thread
@@ -66,6 +69,7 @@ private:
 
     void processChunkGeneration();
     void processMeshQueue();
+    bool meshChunk(uint64_t hash, int lod, uint8_t airBorders);
     GLuint textVAO = 0;
     GLuint textVBO = 0;
     GLuint textEBO = 0;
@@ -83,8 +87,9 @@ private:
     World* world;
     
     std::unordered_map<uint64_t, Mesh> chunksMesh;
-    std::vector<std::pair<uint64_t, MeshData>> meshQueue;
-    std::unordered_map<uint64_t, std::shared_ptr<Chunk>> meshCreationQueue;
+    std::vector<std::pair<uint64_t, ChunkMeshData>> meshQueue;
+    std::unordered_set<uint64_t> meshCreationQueue; // hashes, the chunk is looked up when it's meshed
+    std::unordered_set<uint64_t> meshesInFlight; // handed to a mesh worker, not in meshQueue yet (meshCreationQueueMutex)
     std::vector<uint64_t> chunksToDeleteQueue;
 
     MeshSystem meshSystem;
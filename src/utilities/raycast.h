@@ -2,6 +2,7 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include "../world/chunk.h"
+#include "../world/chunk_grid.h"
 #include <memory>
 
 struct RaycastHit {
@@ -12,7 +13,7 @@ struct RaycastHit {
     glm::ivec3 faceNormal;  // face normal (-1/0/1 per axis)
 };
 
-inline RaycastHit raycast( const glm::vec3& origin, const glm::vec3& dir, float maxDist, const std::unordered_map<uint64_t, std::shared_ptr<Chunk>>& chunkMap) {
+inline RaycastHit raycast( const glm::vec3& origin, const glm::vec3& dir, float maxDist, const ChunkGrid& chunkGrid) {
     RaycastHit result;
     glm::vec3 rayDir = glm::normalize(dir);
     glm::ivec3 blockPos = glm::floor(origin);
@@ -42,17 +43,16 @@ inline RaycastHit raycast( const glm::vec3& origin, const glm::vec3& dir, float
 
         uint64_t hash = hashChunkCoords(cx, cy, cz);
 
-        auto it = chunkMap.find(hash);
-        if (it != chunkMap.end()) {
-            const Chunk& chunk = *(it->second);
+        const Chunk* found = chunkGrid.find(cx, cy, cz);
+        if (found) {
+            const Chunk& chunk = *found;
             int lx = getLocalCoord(blockPos.x);
             int ly = getLocalCoord(blockPos.y);
             int lz = getLocalCoord(blockPos.z);
 
-            uint8_t id = getBlockID(chunk, lx, ly, lz);
-            if (id != 0) {
+            if (isBlockSolid(chunk, lx, ly, lz)) {
                 Block block;
-                block.data.id = id;
+                block.data.id = getBlockID(chunk, lx, ly, lz);
                 block.position = blockPos;
 
                 result.block = block;
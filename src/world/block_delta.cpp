@@ -0,0 +1,103 @@
+#include "block_delta.h"
+#include "../config.h"
+#include <algorithm>
+
+static constexpr uint32_t BLOCKS_PER_CHUNK = CHUNK_VOLUME;
+
+static void writeVarint(std::vector<char>& data, uint32_t value) {
+    while (value >= 0x80) {
+        data.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    data.push_back(static_cast<char>(value));
+}
+
+static bool readVarint(const char*& data, const char* end, uint32_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 32 && data < end; shift += 7) {
+        uint8_t byte = static_cast<uint8_t>(*data++);
+        value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+static bool sameBlock(const BlockData& a, const BlockData& b) {
+    return a.id == b.id && a.rotation == b.rotation;
+}
+
+void BlockDelta::set(uint16_t index, const BlockData& data) {
+    auto it = std::lower_bound(entries.begin(), entries.end(), index, [](const Entry& entry, uint16_t value) { return entry.index < value; });
+    if (it != entries.end() && it->index == index) {
+        it->data = data;
+    } else {
+        entries.insert(it, Entry{index, data});
+    }
+}
+
+void BlockDelta::applyTo(BlockStorage& blocks) const {
+    for (const Entry& entry : entries) {
+        blocks.set(blockIndexFromLinear(entry.index), entry.data);
+    }
+}
+
+void BlockDelta::encode(std::vector<char>& data) const {
+    std::vector<char> runs;
+    uint32_t runCount = 0;
+    uint32_t next = 0; // first index after the last run
+
+    for (size_t i = 0; i < entries.size();) {
+        size_t end = i + 1;
+        while (end < entries.size() && entries[end].index == entries[end - 1].index + 1 && sameBlock(entries[end].data, entries[i].data)) {
+            end++;
+        }
+
+        writeVarint(runs, entries[i].index - next);
+        writeVarint(runs, static_cast<uint32_t>(end - i - 1));
+        runs.push_back(static_cast<char>(entries[i].data.id));
+        runs.push_back(static_cast<char>(entries[i].data.rotation));
+
+        next = entries[end - 1].index + 1;
+        runCount++;
+        i = end;
+    }
+
+    writeVarint(data, runCount);
+    data.insert(data.end(), runs.begin(), runs.end());
+}
+
+bool BlockDelta::decode(const char* data, size_t size) {
+    entries.clear();
+    const char* end = data + size;
+
+    uint32_t runCount = 0;
+    if (!readVarint(data, end, runCount) || runCount > BLOCKS_PER_CHUNK) return false;
+
+    uint32_t next = 0;
+    for (uint32_t i = 0; i < runCount; i++) {
+        uint32_t gap, length;
+        if (!readVarint(data, end, gap) || !readVarint(data, end, length) || end - data < 2) {
+            entries.clear();
+            return false;
+        }
+
+        BlockData block;
+        block.id = static_cast<uint8_t>(data[0]);
+        block.rotation = static_cast<uint8_t>(data[1]);
+        data += 2;
+
+        uint32_t first = next + gap;
+        if (gap > BLOCKS_PER_CHUNK || length >= BLOCKS_PER_CHUNK || first + length >= BLOCKS_PER_CHUNK) {
+            entries.clear();
+            return false;
+        }
+
+        // runs come in index order so appending keeps the array sorted
+        for (uint32_t index = first; index <= first + length; index++) {
+            entries.push_back(Entry{static_cast<uint16_t>(index), block});
+        }
+        next = first + length + 1;
+    }
+
+    return data == end;
+}
\ No newline at end of file
@@ -0,0 +1,35 @@
+#pragma once
+#include "./block.h"
+#include "./block_storage.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// blocks a chunk has changed on top of the generated terrain
+// flat array sorted by linear block index (linearBlockIndex, whatever the storage layout), 4 bytes per edit
+class BlockDelta {
+public:
+    struct Entry {
+        uint16_t index;
+        BlockData data;
+    };
+
+    // adds the block or replaces the one already stored for this index
+    void set(uint16_t index, const BlockData& data);
+
+    bool empty() const { return entries.empty(); }
+    size_t size() const { return entries.size(); }
+    void clear() { entries.clear(); }
+    const std::vector<Entry>& getEntries() const { return entries; }
+
+    // one pass over the sorted edits
+    void applyTo(BlockStorage& blocks) const;
+
+    // varint count of runs | per run: varint gap from the end of the last run, varint length - 1, id, rotation
+    // a run is consecutive indices holding the same block, so a dug out area costs a few bytes
+    void encode(std::vector<char>& data) const;
+    bool decode(const char* data, size_t size);
+
+private:
+    std::vector<Entry> entries;
+};
\ No newline at end of file
@@ -0,0 +1,39 @@
+#pragma once
+#include "../config.h"
+#include <cstdint>
+
+// every index into BlockStorage goes through blockIndex(), the order is picked with BLOCK_LAYOUT in config.h
+// saved edits (BlockDelta, edit journal, region files) always use linearBlockIndex() so worlds load with either layout
+
+static_assert((CHUNK_SIZE & (CHUNK_SIZE - 1)) == 0 && CHUNK_SIZE <= 1024, "morton layout needs a power of two chunk size");
+
+constexpr int linearBlockIndex(int x, int y, int z) {
+    return x + y * CHUNK_SIZE + z * CHUNK_SIZE * CHUNK_SIZE;
+}
+
+// spreads the low 10 bits of value to every third bit
+constexpr uint32_t spreadBits(uint32_t value) {
+    value = (value | (value << 16)) & 0x030000FF;
+    value = (value | (value << 8)) & 0x0300F00F;
+    value = (value | (value << 4)) & 0x030C30C3;
+    value = (value | (value << 2)) & 0x09249249;
+    return value;
+}
+
+constexpr int mortonBlockIndex(int x, int y, int z) {
+    return static_cast<int>(spreadBits(x) | (spreadBits(y) << 1) | (spreadBits(z) << 2));
+}
+
+constexpr int blockIndex(int x, int y, int z) {
+    if constexpr (BLOCK_LAYOUT == BlockLayout::Morton) {
+        return mortonBlockIndex(x, y, z);
+    } else {
+        return linearBlockIndex(x, y, z);
+    }
+}
+
+// storage index of a saved (linear) index
+constexpr int blockIndexFromLinear(int index) {
+    if constexpr (BLOCK_LAYOUT == BlockLayout::Linear) return index;
+    return blockIndex(index % CHUNK_SIZE, (index / CHUNK_SIZE) % CHUNK_SIZE, index / (CHUNK_SIZE * CHUNK_SIZE));
+}
\ No newline at end of file
@@ -0,0 +1,206 @@
+#include "block_storage.h"
+#include <algorithm>
+
+static bool sameBlock(const BlockData& a, const BlockData& b) {
+    return a.id == b.id && a.rotation == b.rotation;
+}
+
+// smallest supported width that holds paletteSize different indices
+static int bitsForPalette(size_t paletteSize) {
+    if (paletteSize <= 1) return 0;
+
+    int bits = 1;
+    while ((size_t(1) << bits) < paletteSize) bits *= 2;
+    return bits;
+}
+
+// bits of the blocks on each face of the chunk, in occupancy order
+static const std::array<std::array<uint64_t, OCCUPANCY_WORDS>, 6>& faceMasks() {
+    static const std::array<std::array<uint64_t, OCCUPANCY_WORDS>, 6> masks = [] {
+        std::array<std::array<uint64_t, OCCUPANCY_WORDS>, 6> result{};
+        for (int a = 0; a < CHUNK_SIZE; a++) {
+            for (int b = 0; b < CHUNK_SIZE; b++) {
+                const int last = CHUNK_SIZE - 1;
+                const int faceIndices[6] = {
+                    blockIndex(last, a, b), blockIndex(0, a, b),
+                    blockIndex(a, last, b), blockIndex(a, 0, b),
+                    blockIndex(a, b, last), blockIndex(a, b, 0)
+                };
+                for (int face = 0; face < 6; face++) {
+                    result[face][faceIndices[face] >> 6] |= uint64_t(1) << (faceIndices[face] & 63);
+                }
+            }
+        }
+        return result;
+    }();
+    return masks;
+}
+
+BlockStorage::BlockStorage() {
+    fill(BlockData());
+}
+
+uint32_t BlockStorage::readIndex(int index) const {
+    if (bitsPerBlock == 0) return 0;
+
+    int perWord = 64 / bitsPerBlock;
+    uint64_t mask = (uint64_t(1) << bitsPerBlock) - 1;
+    return static_cast<uint32_t>((words[index / perWord] >> ((index % perWord) * bitsPerBlock)) & mask);
+}
+
+void BlockStorage::writeIndex(int index, uint32_t value) {
+    int perWord = 64 / bitsPerBlock;
+    int shift = (index % perWord) * bitsPerBlock;
+    uint64_t mask = ((uint64_t(1) << bitsPerBlock) - 1) << shift;
+
+    uint64_t& word = words[index / perWord];
+    word = (word & ~mask) | ((uint64_t(value) << shift) & mask);
+}
+
+BlockData BlockStorage::get(int index) const {
+    return palette[readIndex(index)];
+}
+
+void BlockStorage::set(int index, const BlockData& block) {
+    if (bitsPerBlock == 0 && sameBlock(palette[0], block)) return;
+
+    writeIndex(index, findOrAddPalette(block));
+    setSolid(index, block.id != 0);
+}
+
+void BlockStorage::setSolid(int index, bool solid) {
+    uint64_t bit = uint64_t(1) << (index & 63);
+    uint64_t& word = occupancy[index >> 6];
+    if (((word & bit) != 0) == solid) return;
+    word ^= bit;
+
+    for (int face = 0; face < 6; face++) {
+        if (!(faceMasks()[face][index >> 6] & bit)) continue;
+
+        if (solid) {
+            updateSolidFaces();
+            return;
+        }
+        solidFaces &= ~(1 << face);
+    }
+}
+
+void BlockStorage::updateSolidFaces() {
+    solidFaces = 0;
+    for (int face = 0; face < 6; face++) {
+        const auto& mask = faceMasks()[face];
+        bool full = true;
+        for (int i = 0; i < OCCUPANCY_WORDS && full; i++) {
+            full = (occupancy[i] & mask[i]) == mask[i];
+        }
+        if (full) solidFaces |= 1 << face;
+    }
+}
+
+uint32_t BlockStorage::findOrAddPalette(const BlockData& block) {
+    for (size_t i = 0; i < palette.size(); i++) {
+        if (sameBlock(palette[i], block)) return static_cast<uint32_t>(i);
+    }
+
+    // blocks removed by edits keep their palette entry, rebuilding the palette only happens in pack()
+    palette.push_back(block);
+    if (bitsForPalette(palette.size()) > bitsPerBlock) {
+        setBitsPerBlock(bitsForPalette(palette.size()));
+    }
+    return static_cast<uint32_t>(palette.size() - 1);
+}
+
+void BlockStorage::setBitsPerBlock(int bits) {
+    std::vector<uint32_t> indices(CHUNK_VOLUME);
+    if (bitsPerBlock > 0) {
+        for (int i = 0; i < CHUNK_VOLUME; i++) {
+            indices[i] = readIndex(i);
+        }
+    }
+
+    bitsPerBlock = bits;
+    words.assign(CHUNK_VOLUME * bits / 64, 0);
+    for (int i = 0; i < CHUNK_VOLUME; i++) {
+        writeIndex(i, indices[i]);
+    }
+}
+
+// keeps the capacity like reset(), a filled chunk that gets edited or recycled grows back into the same buffers
+void BlockStorage::fill(const BlockData& block) {
+    palette.assign(1, block);
+    bitsPerBlock = 0;
+    words.clear();
+
+    occupancy.fill(block.id != 0 ? ~uint64_t(0) : 0);
+    solidFaces = block.id != 0 ? 0x3F : 0;
+}
+
+void BlockStorage::reset() {
+    palette.assign(1, BlockData());
+    bitsPerBlock = 0;
+    words.clear();
+
+    occupancy.fill(0);
+    solidFaces = 0;
+}
+
+void BlockStorage::unpack(BlockData* blocks) const {
+    unpackRange(0, CHUNK_VOLUME, blocks);
+}
+
+// whole words at a time, no per block division
+void BlockStorage::unpackRange(int index, int count, BlockData* blocks) const {
+    if (count <= 0) return;
+
+    if (bitsPerBlock == 0) {
+        std::fill(blocks, blocks + count, palette[0]);
+        return;
+    }
+
+    int perWord = 64 / bitsPerBlock;
+    uint64_t mask = (uint64_t(1) << bitsPerBlock) - 1;
+
+    int end = index + count;
+    int wordIndex = index / perWord;
+    int slot = index % perWord;
+    uint64_t word = words[wordIndex] >> (slot * bitsPerBlock);
+
+    for (int i = index; i < end; i++) {
+        *blocks++ = palette[word & mask];
+        word >>= bitsPerBlock;
+
+        if (++slot == perWord && i + 1 < end) {
+            slot = 0;
+            word = words[++wordIndex];
+        }
+    }
+}
+
+void BlockStorage::pack(const BlockData* blocks) {
+    palette.clear();
+    std::vector<uint32_t> indices(CHUNK_VOLUME);
+
+    // runs of the same block are common, skip the palette search for them
+    uint32_t last = 0;
+    occupancy.fill(0);
+    for (int i = 0; i < CHUNK_VOLUME; i++) {
+        if (blocks[i].id != 0) occupancy[i >> 6] |= uint64_t(1) << (i & 63);
+
+        if (i == 0 || !sameBlock(blocks[i], palette[last])) {
+            last = static_cast<uint32_t>(std::find_if(palette.begin(), palette.end(), [&](const BlockData& entry) { return sameBlock(entry, blocks[i]); }) - palette.begin());
+            if (last == palette.size()) palette.push_back(blocks[i]);
+        }
+        indices[i] = last;
+    }
+
+    updateSolidFaces();
+
+    // no shrinking, a reused chunk keeps the buffers it had
+    bitsPerBlock = bitsForPalette(palette.size());
+    words.assign(CHUNK_VOLUME * bitsPerBlock / 64, 0);
+    if (bitsPerBlock == 0) return;
+
+    for (int i = 0; i < CHUNK_VOLUME; i++) {
+        writeIndex(i, indices[i]);
+    }
+}
\ No newline at end of file
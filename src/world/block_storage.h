@@ -0,0 +1,65 @@
+#pragma once
+#include "./block.h"
+#include "./block_layout.h"
+#include "../config.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+static constexpr int CHUNK_VOLUME = CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE;
+static constexpr int OCCUPANCY_WORDS = CHUNK_VOLUME / 64;
+
+// blocks of one chunk as a palette of the different blocks in it + a palette index per block
+// indices are packed 1, 2, 4, 8 (or 16) bits each, widened when a new block doesn't fit in the palette anymore
+// typical terrain (stone, dirt, air, a few ores) is 4 bits per block - 2 KB instead of 8 KB
+// a chunk of one block (sky, deep stone) has 0 bits per block and no index array at all
+// indices (and unpack/pack order) are blockIndex(x, y, z)
+//
+// next to the blocks it keeps a bit per block (set - not air) and which of the chunk's 6 faces are all non-air,
+// both updated by every write, so solid tests don't decode the palette and a whole side is checked with one bit
+class BlockStorage {
+public:
+    BlockStorage(); // all air
+
+    BlockData get(int index) const;
+    void set(int index, const BlockData& block);
+
+    // every block in the chunk the same
+    void fill(const BlockData& block);
+
+    // back to all air but keeps the allocated buffers, for chunks that get reused
+    void reset();
+
+    // bulk copies for the mesher, generator and saving, much faster than get/set per block
+    void unpack(BlockData* blocks) const;                          // all CHUNK_VOLUME blocks
+    void unpackRange(int index, int count, BlockData* blocks) const;
+    void pack(const BlockData* blocks);                            // all CHUNK_VOLUME blocks, palette rebuilt to the minimum
+
+    bool isSolid(int index) const { return (occupancy[index >> 6] >> (index & 63)) & 1; }
+    const std::array<uint64_t, OCCUPANCY_WORDS>& getOccupancy() const { return occupancy; }
+
+    // faces in neighbor order: +x, -x, +y, -y, +z, -z
+    bool isFaceSolid(int face) const { return (solidFaces >> face) & 1; }
+    uint8_t getSolidFaces() const { return solidFaces; }
+
+    bool isUniform() const { return bitsPerBlock == 0; }
+    int getBitsPerBlock() const { return bitsPerBlock; }
+    size_t getPaletteSize() const { return palette.size(); }
+    size_t memoryBytes() const { return palette.capacity() * sizeof(BlockData) + words.capacity() * sizeof(uint64_t) + sizeof(occupancy); }
+
+private:
+    uint32_t readIndex(int index) const;
+    void writeIndex(int index, uint32_t value);
+    uint32_t findOrAddPalette(const BlockData& block);
+    void setBitsPerBlock(int bits);
+    void setSolid(int index, bool solid);
+    void updateSolidFaces();
+
+    std::vector<BlockData> palette;
+    std::vector<uint64_t> words; // 64 / bitsPerBlock indices each, never split over two words
+    int bitsPerBlock = 0;
+
+    std::array<uint64_t, OCCUPANCY_WORDS> occupancy;
+    uint8_t solidFaces = 0;
+};
\ No newline at end of file
@@ -1,17 +1,23 @@
 #pragma once
+#include <atomic>
 #include <vector>
 #include <glm/glm.hpp>
 #include "./block.h"
+#include "./block_delta.h"
+#include "./block_storage.h"
 #include "../config.h"
-#include <iostream>
-#include <fstream>
-#include <filesystem>
 
 struct Chunk {
     glm::vec3 position;
     
-    std::unordered_map<uint64_t, BlockData> modifiedBlockMap;
-    BlockData blocks[CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE] = {}; // 8x8x8 blocks, each block ID is 1 byte (0-255)
+    BlockDelta modifiedBlocks; // player edits, the only part of a chunk that gets saved
+
+    // bumped by every edit, a chunk only needs saving when the saved generation is behind
+    // odd while an edit changes the blocks (World::beginBlockEdit), mesh jobs copy the chunk without the grid lock
+    std::atomic<uint32_t> editGeneration{0};
+    uint32_t savedGeneration = 0;
+
+    BlockStorage blocks; // palette compressed, use the functions below or the bulk unpack/pack
 };
 
 inline uint64_t hashChunkCoords(int x, int y, int z) {
@@ -23,7 +29,16 @@ inline uint64_t hashChunkCoords(int x, int y, int z) {
 }
 
 inline uint8_t getBlockID(const Chunk& chunk, int x, int y, int z) {
-    return chunk.blocks[x + y * CHUNK_SIZE + z * CHUNK_SIZE * CHUNK_SIZE].id; // x + y*chunkSize + z*chunkSize*chunkSize; (0-7 coords)
+    return chunk.blocks.get(blockIndex(x, y, z)).id; // 0-15 coords
+}
+
+// not air, one bit test instead of a palette lookup
+inline bool isBlockSolid(const Chunk& chunk, int x, int y, int z) {
+    return chunk.blocks.isSolid(blockIndex(x, y, z));
+}
+
+inline BlockData getBlock(const Chunk& chunk, int x, int y, int z) {
+    return chunk.blocks.get(blockIndex(x, y, z));
 }
 
 inline int getLocalCoord(int worldCoord) {
@@ -33,23 +48,42 @@ inline int getLocalCoord(int worldCoord) {
 }
 
 inline void setBlockID(Chunk& chunk, int x, int y, int z, uint8_t id) {
-    chunk.blocks[x + y * CHUNK_SIZE + z * CHUNK_SIZE * CHUNK_SIZE].id = id;
+    int index = blockIndex(x, y, z);
+    BlockData block = chunk.blocks.get(index);
+    block.id = id;
+    chunk.blocks.set(index, block);
 }
 
+// player edits, a loaded chunk is edited between World::beginBlockEdit and endBlockEdit
 inline void changeBlockID(Chunk& chunk, int x, int y, int z, uint8_t id) {
-    chunk.blocks[x + y * CHUNK_SIZE + z * CHUNK_SIZE * CHUNK_SIZE].id = id;
-    chunk.blocks[x + y * CHUNK_SIZE + z * CHUNK_SIZE * CHUNK_SIZE].rotation = 0;
+    BlockData block;
+    block.id = id;
+    block.rotation = 0;
+    chunk.blocks.set(blockIndex(x, y, z), block);
 
-    uint64_t key = hashChunkCoords(x, y, z);
-    chunk.modifiedBlockMap[key].id = id;
-    chunk.modifiedBlockMap[key].rotation = 0;
+    chunk.modifiedBlocks.set(linearBlockIndex(x, y, z), block);
 }
 
 inline void changeBlockRotation(Chunk& chunk, int x, int y, int z, uint8_t rotation) {
-    chunk.blocks[x + y * CHUNK_SIZE + z * CHUNK_SIZE * CHUNK_SIZE].rotation= rotation;
+    int index = blockIndex(x, y, z);
+    BlockData block = chunk.blocks.get(index);
+    block.rotation = rotation;
+    chunk.blocks.set(index, block);
+
+    chunk.modifiedBlocks.set(linearBlockIndex(x, y, z), block);
+}
+
+// like a new chunk, but block storage keeps its memory
+inline void resetChunk(Chunk& chunk) {
+    chunk.position = glm::vec3(0.0f);
+    chunk.blocks.reset();
+    chunk.modifiedBlocks.clear();
+    chunk.editGeneration = 0;
+    chunk.savedGeneration = 0;
+}
 
-    uint64_t key = hashChunkCoords(x, y, z);
-    chunk.modifiedBlockMap[key].rotation= rotation;
+inline bool isChunkDirty(const Chunk& chunk) {
+    return chunk.editGeneration != chunk.savedGeneration;
 }
 
 inline void decodeChunkHash(uint64_t hash, int &x, int &y, int &z) {
@@ -66,102 +100,4 @@ inline void decodeChunkHash(uint64_t hash, int &x, int &y, int &z) {
 
 inline int getChunkHashFromWorldCoords(int x, int y, int z) {
     return hashChunkCoords(floor(x / CHUNK_SIZE), floor(y / CHUNK_SIZE), floor(z / CHUNK_SIZE));
-}
-
-
-inline void writeChunkToFile(const Chunk& chunk, int seed) {
-    if (chunk.modifiedBlockMap.empty()) return;
-
-    std::string CHUNK_FOLDER = "worlds/" + std::to_string(seed);
-
-    try {
-        if (!std::filesystem::exists(CHUNK_FOLDER)) {
-            std::filesystem::create_directories(CHUNK_FOLDER);
-            std::cout << "Created directory: " << CHUNK_FOLDER << std::endl;
-        }
-    } catch (const std::exception& e) {
-        std::cerr << "Error creating directory: " << e.what() << std::endl;
-        return;
-    }
-
-    std::string filename = std::to_string(chunk.position.x / CHUNK_SIZE) + "_" + std::to_string(chunk.position.y / CHUNK_SIZE) + "_" + std::to_string(chunk.position.z / CHUNK_SIZE) + ".chunk";
-    
-    std::ofstream outputFile(CHUNK_FOLDER + "/" + filename, std::ios::out | std::ios::binary);
-    if (!outputFile.is_open()) {
-        std::cerr << "Error: Could not open file for writing." << std::endl;
-        return;
-    }
-
-    size_t numBlocks = chunk.modifiedBlockMap.size();
-    outputFile.write(reinterpret_cast<const char*>(&numBlocks), sizeof(numBlocks));
-
-    for (const auto& pair : chunk.modifiedBlockMap) {
-        outputFile.write(reinterpret_cast<const char*>(&pair.first), sizeof(pair.first));
-        outputFile.write(reinterpret_cast<const char*>(&pair.second.id), sizeof(pair.second.id));
-        outputFile.write(reinterpret_cast<const char*>(&pair.second.rotation), sizeof(pair.second.rotation));
-    }
-
-    outputFile.close();
-    std::cout << "Saved " << numBlocks << " modified blocks." << std::endl;
-}
-
-inline bool readChunkFromFile(Chunk& chunk, int seed) {
-    std::string CHUNK_FOLDER = "worlds/" + std::to_string(seed);
-    std::string filename = std::to_string(chunk.position.x / CHUNK_SIZE) + "_" + std::to_string(chunk.position.y / CHUNK_SIZE) + "_" + std::to_string(chunk.position.z / CHUNK_SIZE) + ".chunk";
-    std::string fullPath = CHUNK_FOLDER + "/" + filename;
-
-    std::ifstream inputFile(fullPath, std::ios::in | std::ios::binary);
-    if (!inputFile.is_open()) return false;
-
-    try {
-        size_t numBlocks = 0;
-        inputFile.read(reinterpret_cast<char*>(&numBlocks), sizeof(numBlocks));
-
-        // Quick sanity check
-        if (numBlocks > CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE) {
-            std::cerr << "Chunk file is corrupted (too many blocks): " << fullPath << std::endl;
-            return false;
-        }
-
-        for (size_t i = 0; i < numBlocks; ++i) {
-            uint64_t key = 0;
-            BlockData data{};
-            
-            // Check that reading does not fail
-            if (!inputFile.read(reinterpret_cast<char*>(&key), sizeof(key)) ||
-                !inputFile.read(reinterpret_cast<char*>(&data.id), sizeof(data.id)) ||
-                !inputFile.read(reinterpret_cast<char*>(&data.rotation), sizeof(data.rotation))) 
-            {
-                std::cerr << "Chunk file read error or corrupted: " << fullPath << std::endl;
-                return false;
-            }
-
-            // Basic validation
-            if (data.id > 255) {
-                std::cerr << "Invalid block data in file: " << fullPath << std::endl;
-                continue; // skip corrupted block
-            }
-
-            chunk.modifiedBlockMap[key] = data;
-
-            int x, y, z;
-            decodeChunkHash(key, x, y, z);
-
-            // Validate coordinates inside chunk bounds
-            if (x < 0 || x >= CHUNK_SIZE || y < 0 || y >= CHUNK_SIZE || z < 0 || z >= CHUNK_SIZE) {
-                std::cerr << "Block coordinates out of bounds: " << key << std::endl;
-                continue;
-            }
-
-            chunk.blocks[x + y * CHUNK_SIZE + z * CHUNK_SIZE * CHUNK_SIZE] = data;
-        }
-
-        inputFile.close();
-        std::cout << "Successfully read " << chunk.modifiedBlockMap.size() << " modified blocks from " << fullPath << std::endl;
-        return true;
-
-    } catch (const std::exception& e) {
-        std::cerr << "Exception reading chunk file " << fullPath << ": " << e.what() << std::endl;
-        return false;
-    }
 }
\ No newline at end of file
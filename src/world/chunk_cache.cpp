@@ -0,0 +1,154 @@
+#include "chunk_cache.h"
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <iostream>
+
+ChunkSnapshotCache::ChunkSnapshotCache(const std::string& folder, uint32_t generatorVersion) : storage(folder, ".cache", generatorVersion) {
+
+}
+
+bool ChunkSnapshotCache::load(Chunk& chunk) {
+    int cx = static_cast<int>(std::floor(chunk.position.x / CHUNK_SIZE));
+    int cy = static_cast<int>(std::floor(chunk.position.y / CHUNK_SIZE));
+    int cz = static_cast<int>(std::floor(chunk.position.z / CHUNK_SIZE));
+
+    std::vector<char> data;
+    if (storage.readPayload(cx, cy, cz, data) != ReadResult::Found) return false;
+
+    // decode only touches the chunk when it succeeds, so generation still gets an all air chunk
+    if (!decode(data, chunk)) {
+        std::cerr << "Cached chunk is corrupted, generating it again: " << cx << " " << cy << " " << cz << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void ChunkSnapshotCache::store(const Chunk& chunk) {
+    int cx = static_cast<int>(std::floor(chunk.position.x / CHUNK_SIZE));
+    int cy = static_cast<int>(std::floor(chunk.position.y / CHUNK_SIZE));
+    int cz = static_cast<int>(std::floor(chunk.position.z / CHUNK_SIZE));
+
+    std::vector<char> data;
+    encode(chunk, data);
+    storage.writePayload(cx, cy, cz, data);
+}
+
+// uint16 palette size | (id, rotation) per palette entry | runs of (palette index, uint16 length) until the chunk is full
+// palette index is 1 byte while the palette fits, 2 bytes otherwise
+// a chunk of one block is just the palette (no runs), 4 bytes
+void ChunkSnapshotCache::encode(const Chunk& chunk, std::vector<char>& data) {
+    const int blockCount = CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE;
+
+    if (chunk.blocks.isUniform()) {
+        BlockData blockData = chunk.blocks.get(0);
+        uint16_t paletteSize = 1;
+
+        data.clear();
+        data.insert(data.end(), reinterpret_cast<const char*>(&paletteSize), reinterpret_cast<const char*>(&paletteSize) + sizeof(paletteSize));
+        data.push_back(static_cast<char>(blockData.id));
+        data.push_back(static_cast<char>(blockData.rotation));
+        return;
+    }
+
+    // (rotation << 8 | id) -> palette index, 256 KB so it's kept per thread and the used entries reset after
+    thread_local std::vector<int> paletteIndex(1 << 16, -1);
+    std::vector<BlockData> palette;
+    std::vector<uint16_t> indices(blockCount);
+
+    std::vector<BlockData> blocks(blockCount);
+    chunk.blocks.unpack(blocks.data());
+
+    for (int i = 0; i < blockCount; i++) {
+        const BlockData& blockData = blocks[i];
+        int key = blockData.id | (blockData.rotation << 8);
+        if (paletteIndex[key] < 0) {
+            paletteIndex[key] = static_cast<int>(palette.size());
+            palette.push_back(blockData);
+        }
+        indices[i] = static_cast<uint16_t>(paletteIndex[key]);
+    }
+
+    for (const BlockData& blockData : palette) {
+        paletteIndex[blockData.id | (blockData.rotation << 8)] = -1;
+    }
+
+    uint16_t paletteSize = static_cast<uint16_t>(palette.size());
+    bool wideIndex = paletteSize > 256;
+
+    data.clear();
+    data.insert(data.end(), reinterpret_cast<const char*>(&paletteSize), reinterpret_cast<const char*>(&paletteSize) + sizeof(paletteSize));
+    for (const BlockData& blockData : palette) {
+        data.push_back(static_cast<char>(blockData.id));
+        data.push_back(static_cast<char>(blockData.rotation));
+    }
+
+    for (int i = 0; i < blockCount; ) {
+        uint16_t index = indices[i];
+        uint16_t length = 1;
+        while (i + length < blockCount && indices[i + length] == index) length++;
+
+        if (wideIndex) {
+            data.insert(data.end(), reinterpret_cast<const char*>(&index), reinterpret_cast<const char*>(&index) + sizeof(index));
+        } else {
+            data.push_back(static_cast<char>(index));
+        }
+        data.insert(data.end(), reinterpret_cast<const char*>(&length), reinterpret_cast<const char*>(&length) + sizeof(length));
+
+        i += length;
+    }
+}
+
+bool ChunkSnapshotCache::decode(const std::vector<char>& data, Chunk& chunk) {
+    const int blockCount = CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE;
+    size_t offset = 0;
+
+    uint16_t paletteSize = 0;
+    if (data.size() < sizeof(paletteSize)) return false;
+    std::memcpy(&paletteSize, data.data(), sizeof(paletteSize));
+    offset += sizeof(paletteSize);
+
+    if (paletteSize == 0 || data.size() < offset + paletteSize * 2) return false;
+
+    std::vector<BlockData> palette(paletteSize);
+    for (BlockData& blockData : palette) {
+        blockData.id = static_cast<uint8_t>(data[offset]);
+        blockData.rotation = static_cast<uint8_t>(data[offset + 1]);
+        offset += 2;
+    }
+
+    if (paletteSize == 1 && offset == data.size()) {
+        chunk.blocks.fill(palette[0]);
+        return true;
+    }
+
+    bool wideIndex = paletteSize > 256;
+    size_t runSize = (wideIndex ? 2 : 1) + sizeof(uint16_t);
+
+    std::vector<BlockData> blocks(blockCount);
+    int block = 0;
+    while (block < blockCount) {
+        if (offset + runSize > data.size()) return false;
+
+        uint16_t index;
+        if (wideIndex) {
+            std::memcpy(&index, data.data() + offset, sizeof(index));
+        } else {
+            index = static_cast<uint8_t>(data[offset]);
+        }
+
+        uint16_t length;
+        std::memcpy(&length, data.data() + offset + runSize - sizeof(length), sizeof(length));
+        offset += runSize;
+
+        if (index >= paletteSize || length == 0 || block + length > blockCount) return false;
+
+        std::fill(blocks.begin() + block, blocks.begin() + block + length, palette[index]);
+        block += length;
+    }
+
+    if (offset != data.size()) return false;
+
+    chunk.blocks.pack(blocks.data());
+    return true;
+}
\ No newline at end of file
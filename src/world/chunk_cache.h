@@ -0,0 +1,22 @@
+#pragma once
+#include "./chunk.h"
+#include "./region_storage.h"
+#include <string>
+#include <vector>
+
+// generated chunk blocks (before the player's edits are applied) so a revisited chunk skips the noise
+// kept palette + run length encoded in region files tagged with the generator version
+class ChunkSnapshotCache {
+public:
+    ChunkSnapshotCache(const std::string& folder, uint32_t generatorVersion);
+
+    // fills chunk.blocks, false when the chunk isn't cached
+    bool load(Chunk& chunk);
+    void store(const Chunk& chunk);
+
+    static void encode(const Chunk& chunk, std::vector<char>& data);
+    static bool decode(const std::vector<char>& data, Chunk& chunk);
+
+private:
+    RegionStorage storage;
+};
\ No newline at end of file
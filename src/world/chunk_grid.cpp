@@ -0,0 +1,140 @@
+#include "chunk_grid.h"
+
+static_assert((CHUNK_GRID_SIZE & (CHUNK_GRID_SIZE - 1)) == 0 && (CHUNK_GRID_HEIGHT & (CHUNK_GRID_HEIGHT - 1)) == 0, "chunk grid sizes have to be powers of two");
+static_assert(CHUNK_GRID_SIZE >= 2 * (RENDER_DISTANCE / 2 + 1) + 1, "chunk grid is smaller than the loaded area");
+static_assert(CHUNK_GRID_HEIGHT >= 2 * (VERTICAL_RENDER_DISTANCE / 2 + 1) + 1, "chunk grid is lower than the loaded area");
+
+ChunkGrid::ChunkGrid(EpochManager& epochs) : slots(CHUNK_GRID_SIZE * CHUNK_GRID_SIZE * CHUNK_GRID_HEIGHT), epochs(epochs) {
+
+}
+
+// & works as modulo for negative coords too, since the sizes are powers of two
+int ChunkGrid::slotIndex(int chunkX, int chunkY, int chunkZ) {
+    int x = chunkX & (CHUNK_GRID_SIZE - 1);
+    int y = chunkY & (CHUNK_GRID_HEIGHT - 1);
+    int z = chunkZ & (CHUNK_GRID_SIZE - 1);
+    return x + z * CHUNK_GRID_SIZE + y * CHUNK_GRID_SIZE * CHUNK_GRID_SIZE;
+}
+
+Chunk* ChunkGrid::find(uint64_t hash) const {
+    int x, y, z;
+    decodeChunkHash(hash, x, y, z);
+    return find(x, y, z);
+}
+
+Chunk* ChunkGrid::find(int chunkX, int chunkY, int chunkZ) const {
+    const Slot& slot = slots[slotIndex(chunkX, chunkY, chunkZ)];
+    uint64_t hash = hashChunkCoords(chunkX, chunkY, chunkZ);
+
+    uint32_t version;
+    uint64_t slotHash;
+    Chunk* chunk;
+    do {
+        version = slot.version.load(std::memory_order_acquire);
+        slotHash = slot.hash.load(std::memory_order_relaxed);
+        chunk = slot.chunk.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while ((version & 1) || version != slot.version.load(std::memory_order_relaxed));
+
+    if (chunk && slotHash == hash) return chunk;
+
+    // almost always empty, then there's nothing to lock
+    if (pinnedCount.load(std::memory_order_acquire) == 0) return nullptr;
+
+    std::lock_guard<std::mutex> lock(pinnedMutex);
+    auto it = pinned.find(hash);
+    if (it != pinned.end()) return it->second.get();
+
+    // it could have moved from the map into its slot after the read above, slots only change that way under this lock
+    chunk = slot.chunk.load(std::memory_order_relaxed);
+    return chunk && slot.hash.load(std::memory_order_relaxed) == hash ? chunk : nullptr;
+}
+
+void ChunkGrid::writeSlot(Slot& slot, uint64_t hash, std::shared_ptr<Chunk> chunk) {
+    uint32_t version = slot.version.load(std::memory_order_relaxed);
+    slot.version.store(version + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot.hash.store(hash, std::memory_order_relaxed);
+    slot.chunk.store(chunk.get(), std::memory_order_relaxed);
+    slot.version.store(version + 2, std::memory_order_release);
+
+    slot.owner = std::move(chunk);
+}
+
+bool ChunkGrid::insert(uint64_t hash, std::shared_ptr<Chunk> chunk) {
+    if (find(hash)) return false;
+
+    int x, y, z;
+    decodeChunkHash(hash, x, y, z);
+    Slot& slot = slots[slotIndex(x, y, z)];
+
+    if (!slot.owner) {
+        writeSlot(slot, hash, std::move(chunk));
+    } else {
+        std::lock_guard<std::mutex> lock(pinnedMutex);
+        pinned.emplace(hash, std::move(chunk));
+        pinnedCount.store(pinned.size(), std::memory_order_release);
+    }
+
+    count++;
+    return true;
+}
+
+void ChunkGrid::remove(uint64_t hash) {
+    int x, y, z;
+    decodeChunkHash(hash, x, y, z);
+    int index = slotIndex(x, y, z);
+    Slot& slot = slots[index];
+
+    std::shared_ptr<Chunk> removed;
+    if (slot.owner && slot.hash.load(std::memory_order_relaxed) == hash) {
+        removed = slot.owner;
+
+        // a pinned chunk waiting for this slot moves in
+        std::lock_guard<std::mutex> lock(pinnedMutex);
+        auto next = pinned.begin();
+        for (; next != pinned.end(); ++next) {
+            int px, py, pz;
+            decodeChunkHash(next->first, px, py, pz);
+            if (slotIndex(px, py, pz) == index) break;
+        }
+
+        if (next != pinned.end()) {
+            writeSlot(slot, next->first, next->second);
+            pinned.erase(next);
+            pinnedCount.store(pinned.size(), std::memory_order_release);
+        } else {
+            writeSlot(slot, 0, nullptr);
+        }
+    } else {
+        std::lock_guard<std::mutex> lock(pinnedMutex);
+        auto it = pinned.find(hash);
+        if (it == pinned.end()) return;
+
+        removed = std::move(it->second);
+        pinned.erase(it);
+        pinnedCount.store(pinned.size(), std::memory_order_release);
+    }
+
+    count--;
+    epochs.retire(std::move(removed));
+}
+
+void ChunkGrid::forEach(const std::function<void(uint64_t hash, Chunk& chunk)>& function) const {
+    for (const Slot& slot : slots) {
+        if (slot.owner) function(slot.hash.load(std::memory_order_relaxed), *slot.owner);
+    }
+
+    // copied so the function can call find()
+    std::vector<std::pair<uint64_t, Chunk*>> pinnedChunks;
+    {
+        std::lock_guard<std::mutex> lock(pinnedMutex);
+        for (const auto& [hash, chunk] : pinned) {
+            pinnedChunks.emplace_back(hash, chunk.get());
+        }
+    }
+    for (const auto& [hash, chunk] : pinnedChunks) {
+        function(hash, *chunk);
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include "./chunk.h"
+#include "./epoch_manager.h"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// loaded chunks in a window of slots that wraps around (chunk coords modulo the window size)
+// the loaded box around the player is smaller than the window, so two loaded chunks never want the same slot
+// chunks loaded outside the box (generation finishing after the player moved on) can collide, those go to a fallback map
+//
+// find() is lock free: slots are versioned (odd while written), readers retry until they get a stable read
+// removed chunks are retired to the epoch manager, a pointer from find() stays valid while the caller holds an EpochGuard
+// (or chunkGridMutex shared, nothing can be removed meanwhile)
+//
+// insert/remove/forEach: caller holds the world's chunkGridMutex exclusive (insert/remove) or shared
+class ChunkGrid {
+public:
+    ChunkGrid(EpochManager& epochs);
+
+    Chunk* find(int chunkX, int chunkY, int chunkZ) const;
+    Chunk* find(uint64_t hash) const;
+
+    // false if the chunk is already loaded
+    bool insert(uint64_t hash, std::shared_ptr<Chunk> chunk);
+    void remove(uint64_t hash);
+
+    void forEach(const std::function<void(uint64_t hash, Chunk& chunk)>& function) const;
+    size_t size() const { return count.load(std::memory_order_relaxed); }
+
+private:
+    struct Slot {
+        std::atomic<uint32_t> version{0};
+        std::atomic<uint64_t> hash{0};
+        std::atomic<Chunk*> chunk{nullptr};
+        std::shared_ptr<Chunk> owner;
+    };
+
+    static int slotIndex(int chunkX, int chunkY, int chunkZ);
+    static void writeSlot(Slot& slot, uint64_t hash, std::shared_ptr<Chunk> chunk);
+
+    std::vector<Slot> slots;
+
+    std::unordered_map<uint64_t, std::shared_ptr<Chunk>> pinned; // chunks whose slot was taken
+    std::atomic<size_t> pinnedCount{0};
+    mutable std::mutex pinnedMutex;
+
+    EpochManager& epochs;
+
+    std::atomic<size_t> count{0};
+};
\ No newline at end of file
@@ -0,0 +1,49 @@
+#include "chunk_pool.h"
+
+ChunkPool::ChunkPool(size_t capacity) : capacity(capacity) {
+    freeChunks.reserve(capacity);
+}
+
+std::shared_ptr<Chunk> ChunkPool::acquire() {
+    std::unique_ptr<Chunk> chunk;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!freeChunks.empty()) {
+            chunk = std::move(freeChunks.back());
+            freeChunks.pop_back();
+            stats.reused++;
+        } else {
+            stats.allocated++;
+        }
+        stats.inUse++;
+    }
+
+    if (!chunk) {
+        chunk = std::make_unique<Chunk>();
+    }
+
+    return std::shared_ptr<Chunk>(chunk.release(), [this](Chunk* released) { release(released); });
+}
+
+// runs on whichever thread drops the last reference
+void ChunkPool::release(Chunk* chunk) {
+    std::unique_ptr<Chunk> owned(chunk);
+
+    // reset outside the lock, block storage keeps its buffers for the next chunk
+    resetChunk(*owned);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    stats.inUse--;
+    if (freeChunks.size() < capacity) {
+        freeChunks.push_back(std::move(owned));
+    } else {
+        stats.freed++;
+    }
+}
+
+ChunkPool::Stats ChunkPool::getStats() {
+    std::lock_guard<std::mutex> lock(mutex);
+    Stats current = stats;
+    current.free = freeChunks.size();
+    return current;
+}
\ No newline at end of file
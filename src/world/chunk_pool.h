@@ -0,0 +1,33 @@
+#pragma once
+#include "./chunk.h"
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// recycles unloaded chunks so generation doesn't allocate a chunk (and its block storage) every time
+// acquire() gives a reset chunk, when the last shared_ptr to it goes away it comes back here
+// keeps at most `capacity` free chunks, anything over that is freed
+// chunks hand themselves back to the pool, so it has to outlive them (World declares it before chunkGrid and epochs)
+class ChunkPool {
+public:
+    struct Stats {
+        size_t allocated = 0; // new chunks, the pool was empty
+        size_t reused = 0;    // acquires served from the free list
+        size_t freed = 0;     // released while the free list was full
+        size_t free = 0;      // waiting in the free list right now
+        size_t inUse = 0;
+    };
+
+    ChunkPool(size_t capacity);
+
+    std::shared_ptr<Chunk> acquire();
+    Stats getStats();
+
+private:
+    void release(Chunk* chunk);
+
+    size_t capacity;
+    std::vector<std::unique_ptr<Chunk>> freeChunks;
+    Stats stats;
+    std::mutex mutex;
+};
\ No newline at end of file
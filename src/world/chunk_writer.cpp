@@ -0,0 +1,210 @@
+#include "chunk_writer.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+ChunkWriter::ChunkWriter(RegionStorage& storage) : storage(storage) {
+    thread = std::thread([this]() { writerLoop(); });
+}
+
+ChunkWriter::~ChunkWriter() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+    }
+    wake.notify_all();
+
+    // the loop writes what's left before it returns
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+void ChunkWriter::save(Chunk& chunk) {
+    if (!isChunkDirty(chunk) || chunk.modifiedBlocks.empty()) return;
+    chunk.savedGeneration = chunk.editGeneration; // from here on the queued snapshot is what gets read back
+
+    auto snapshot = std::make_shared<ChunkSnapshot>();
+    snapshot->x = static_cast<int>(std::floor(chunk.position.x / CHUNK_SIZE));
+    snapshot->y = static_cast<int>(std::floor(chunk.position.y / CHUNK_SIZE));
+    snapshot->z = static_cast<int>(std::floor(chunk.position.z / CHUNK_SIZE));
+    snapshot->modifiedBlocks = chunk.modifiedBlocks;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        uint64_t hash = hashChunkCoords(snapshot->x, snapshot->y, snapshot->z);
+        failed.erase(hash); // the newer snapshot has every edit of the failed one
+        pending[hash] = std::move(snapshot);
+    }
+    wake.notify_one();
+}
+
+bool ChunkWriter::readPending(Chunk& chunk) {
+    int cx = static_cast<int>(std::floor(chunk.position.x / CHUNK_SIZE));
+    int cy = static_cast<int>(std::floor(chunk.position.y / CHUNK_SIZE));
+    int cz = static_cast<int>(std::floor(chunk.position.z / CHUNK_SIZE));
+    uint64_t hash = hashChunkCoords(cx, cy, cz);
+
+    std::shared_ptr<const ChunkSnapshot> snapshot;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        // pending is newer than the batch being written, a failed write is older than both
+        for (auto* snapshots : {&pending, &writing, &failed}) {
+            auto it = snapshots->find(hash);
+            if (it != snapshots->end()) {
+                snapshot = it->second;
+                break;
+            }
+        }
+        if (!snapshot) return false;
+    }
+
+    chunk.modifiedBlocks = snapshot->modifiedBlocks;
+    chunk.modifiedBlocks.applyTo(chunk.blocks);
+
+    return true;
+}
+
+bool ChunkWriter::flush(const std::function<void(size_t)>& progress) {
+    bool allWritten;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        requeueFailed();
+
+        // an async flush still running its callbacks counts as unfinished, they can touch things the caller is about to destroy
+        while (!written.wait_for(lock, std::chrono::milliseconds(250), [this]() { return pending.empty() && writing.empty() && flushCallbacks.empty() && !runningCallbacks; })) {
+            if (progress) {
+                size_t left = pending.size() + writing.size() - writtenFromBatch;
+                lock.unlock();
+                progress(left);
+                lock.lock();
+            }
+        }
+
+        allWritten = failed.empty();
+    }
+
+    // one fsync per region file and one for the folder, instead of one per chunk
+    bool synced = storage.sync();
+    return allWritten && synced;
+}
+
+void ChunkWriter::flushAsync(std::function<void(bool)> done) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        requeueFailed();
+        flushCallbacks.push_back(std::move(done));
+    }
+    wake.notify_one();
+}
+
+// another try for chunks that failed before, unless a newer save of them is already queued, mutex held
+void ChunkWriter::requeueFailed() {
+    if (failed.empty()) return;
+
+    for (auto& [hash, snapshot] : failed) {
+        pending.emplace(hash, std::move(snapshot));
+    }
+    failed.clear();
+    wake.notify_one();
+}
+
+size_t ChunkWriter::backlog() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return pending.size() + writing.size() + failed.size() - writtenFromBatch;
+}
+
+void ChunkWriter::writerLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    std::vector<std::shared_ptr<const ChunkSnapshot>> failedWrites;
+
+    while (true) {
+        wake.wait(lock, [this]() { return !running || !pending.empty() || !flushCallbacks.empty(); });
+        if (pending.empty() && flushCallbacks.empty() && !running) break;
+
+        // async flushes finish once everything queued before them is written, then one sync covers all of them
+        if (pending.empty()) {
+            std::vector<std::function<void(bool)>> callbacks;
+            callbacks.swap(flushCallbacks);
+            bool allWritten = failed.empty();
+            runningCallbacks = true;
+            lock.unlock();
+
+            bool synced = storage.sync();
+            for (auto& done : callbacks) {
+                done(allWritten && synced);
+            }
+
+            lock.lock();
+            runningCallbacks = false;
+            written.notify_all();
+            continue;
+        }
+
+        // take everything queued as one batch, saves coming in meanwhile go to a fresh pending map
+        writing.swap(pending);
+        lock.unlock();
+
+        writeBatch(failedWrites);
+        if (!storage.flush()) {
+            // what's buffered can't be told apart per chunk, the whole batch waits for the next flush()
+            failedWrites.clear();
+            for (const auto& [hash, snapshot] : writing) {
+                failedWrites.push_back(snapshot);
+            }
+        }
+
+        lock.lock();
+        for (auto& snapshot : failedWrites) {
+            uint64_t hash = hashChunkCoords(snapshot->x, snapshot->y, snapshot->z);
+            if (!pending.count(hash)) failed[hash] = std::move(snapshot);
+        }
+        failedWrites.clear();
+        writing.clear();
+        writtenFromBatch = 0;
+        written.notify_all();
+    }
+}
+
+void ChunkWriter::writeBatch(std::vector<std::shared_ptr<const ChunkSnapshot>>& failedWrites) {
+    // one group per region file, a file is only ever written by one thread
+    std::unordered_map<uint64_t, std::vector<const ChunkSnapshot*>> regionGroups;
+    for (const auto& [hash, snapshot] : writing) {
+        regionGroups[RegionStorage::regionKey(snapshot->x, snapshot->y, snapshot->z)].push_back(snapshot.get());
+    }
+
+    std::vector<std::vector<const ChunkSnapshot*>> groups;
+    groups.reserve(regionGroups.size());
+    for (auto& [key, group] : regionGroups) {
+        groups.push_back(std::move(group));
+    }
+
+    std::atomic<size_t> nextGroup{0};
+    std::mutex failedMutex;
+    auto writeGroups = [this, &groups, &nextGroup, &failedWrites, &failedMutex]() {
+        for (size_t i = nextGroup++; i < groups.size(); i = nextGroup++) {
+            for (const ChunkSnapshot* snapshot : groups[i]) {
+                if (!storage.writeChunk(snapshot->x, snapshot->y, snapshot->z, snapshot->modifiedBlocks)) {
+                    std::lock_guard<std::mutex> lock(failedMutex);
+                    failedWrites.push_back(writing.at(hashChunkCoords(snapshot->x, snapshot->y, snapshot->z)));
+                }
+                writtenFromBatch++;
+            }
+        }
+    };
+
+    // helpers only live for the batch, most unload batches touch a single region and never start one
+    size_t helperCount = groups.size() > 1 ? std::min<size_t>(CHUNK_WRITER_THREADS, groups.size()) - 1 : 0;
+    std::vector<std::thread> helpers;
+    for (size_t i = 0; i < helperCount; i++) {
+        helpers.emplace_back(writeGroups);
+    }
+
+    writeGroups();
+
+    for (std::thread& helper : helpers) {
+        helper.join();
+    }
+}
\ No newline at end of file
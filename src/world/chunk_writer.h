@@ -0,0 +1,64 @@
+#pragma once
+#include "./chunk.h"
+#include "./region_storage.h"
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+static constexpr int CHUNK_WRITER_THREADS = 4; // most region files written at once
+
+// saves chunks on its own thread so unloading and saving never wait for the disk
+// save() only copies the modified blocks, the thread writes everything queued as one batch
+// a batch touching several region files is split per file over up to CHUNK_WRITER_THREADS threads
+// chunks that fail to write are kept and tried again by the next flush(), which reports whether everything made it
+class ChunkWriter {
+public:
+    ChunkWriter(RegionStorage& storage);
+    ~ChunkWriter();
+
+    // only chunks edited since their last save get queued, a newer save of the same chunk replaces one that is still waiting
+    void save(Chunk& chunk);
+
+    // applies a save that isn't on disk yet, a chunk loaded again right after unloading has to see it
+    bool readPending(Chunk& chunk);
+
+    // blocks until everything queued so far is written and synced to disk
+    // progress gets the number of chunks left every now and then while it waits
+    // false if a chunk couldn't be written or the sync failed, the edit journal has to stay then
+    bool flush(const std::function<void(size_t)>& progress = nullptr);
+
+    // same as flush() without waiting, done gets the result on the writer thread once everything queued so far is synced
+    void flushAsync(std::function<void(bool)> done);
+
+    size_t backlog();
+
+private:
+    struct ChunkSnapshot {
+        int x, y, z;
+        BlockDelta modifiedBlocks;
+    };
+
+    void writerLoop();
+    void writeBatch(std::vector<std::shared_ptr<const ChunkSnapshot>>& failedWrites);
+    void requeueFailed();
+
+    RegionStorage& storage;
+
+    std::unordered_map<uint64_t, std::shared_ptr<const ChunkSnapshot>> pending;
+    std::unordered_map<uint64_t, std::shared_ptr<const ChunkSnapshot>> writing; // batch the thread is on right now
+    std::unordered_map<uint64_t, std::shared_ptr<const ChunkSnapshot>> failed;  // not on disk, queued again by flush()
+    std::vector<std::function<void(bool)>> flushCallbacks; // flushAsync calls waiting for pending to run dry
+    bool runningCallbacks = false;
+    std::atomic<size_t> writtenFromBatch{0};
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable written;
+    bool running = true;
+
+    std::thread thread;
+};
\ No newline at end of file
@@ -0,0 +1,37 @@
+#include "column_cache.h"
+#include <cstdlib>
+
+std::shared_ptr<const Column> ColumnCache::get(int chunkX, int chunkZ, const std::function<void(Column& column)>& compute) {
+    uint64_t key = hashChunkCoords(chunkX, 0, chunkZ);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = columns.find(key);
+        if (it != columns.end()) return it->second;
+    }
+
+    auto column = std::make_shared<Column>();
+    compute(*column);
+
+    // someone else may have computed it meanwhile, theirs is the same
+    std::lock_guard<std::mutex> lock(mutex);
+    return columns.emplace(key, std::move(column)).first->second;
+}
+
+void ColumnCache::evictOutside(int centerX, int centerZ, int distance) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto it = columns.begin(); it != columns.end(); ) {
+        int x, y, z;
+        decodeChunkHash(it->first, x, y, z);
+
+        if (abs(x - centerX) > distance || abs(z - centerZ) > distance) {
+            it = columns.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+size_t ColumnCache::size() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return columns.size();
+}
\ No newline at end of file
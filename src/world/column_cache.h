@@ -0,0 +1,33 @@
+#pragma once
+#include "./biome.h"
+#include "./chunk.h"
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+// 2d terrain data of one chunk column (x, z), the same for every chunk stacked in it
+// index x + z*CHUNK_SIZE, local coords
+struct Column {
+    int height[CHUNK_SIZE * CHUNK_SIZE];
+    double temperature[CHUNK_SIZE * CHUNK_SIZE];
+    double moisture[CHUNK_SIZE * CHUNK_SIZE];
+    BiomeType biome[CHUNK_SIZE * CHUNK_SIZE];
+};
+
+// columns are computed by the first chunk of the column that gets generated, the rest of the stack reuses them
+// so the 2d noise runs once per column instead of once per chunk
+class ColumnCache {
+public:
+    // compute fills a new column, runs without the lock
+    std::shared_ptr<const Column> get(int chunkX, int chunkZ, const std::function<void(Column& column)>& compute);
+
+    // drops columns further than distance chunks from the center (chebyshev, like chunk unloading)
+    void evictOutside(int centerX, int centerZ, int distance);
+
+    size_t size();
+
+private:
+    std::unordered_map<uint64_t, std::shared_ptr<const Column>> columns;
+    std::mutex mutex;
+};
\ No newline at end of file
@@ -0,0 +1,317 @@
+#include "edit_journal.h"
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <unordered_map>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+static constexpr size_t RECORD_SIZE = sizeof(uint32_t) + 3 * sizeof(int32_t) + 2;
+
+static bool syncFile(std::FILE* file) {
+    if (std::fflush(file) != 0) return false;
+#ifdef _WIN32
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+static int floorDiv(int value, int divisor) {
+    int result = value / divisor;
+    if (value % divisor != 0 && value < 0) --result;
+    return result;
+}
+
+EditJournal::EditJournal(const std::string& path) : path(path), rotatedPath(path + ".old") {
+    openFile("ab");
+    thread = std::thread([this]() { syncLoop(); });
+}
+
+EditJournal::~EditJournal() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+    }
+    wake.notify_all();
+
+    // the loop writes what's left before it returns
+    if (thread.joinable()) {
+        thread.join();
+    }
+
+    if (file) {
+        std::fclose(file);
+    }
+}
+
+bool EditJournal::openFile(const char* mode) {
+    if (file) {
+        std::fclose(file);
+    }
+
+    file = std::fopen(path.c_str(), mode);
+    if (!file) {
+        std::cerr << "Error: Could not open edit journal " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void EditJournal::record(int x, int y, int z, const BlockData& block) {
+    char data[RECORD_SIZE];
+    int32_t position[3] = {x, y, z};
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        sequence++;
+        std::memcpy(data, &sequence, sizeof(sequence));
+        std::memcpy(data + sizeof(sequence), position, sizeof(position));
+        data[RECORD_SIZE - 2] = static_cast<char>(block.id);
+        data[RECORD_SIZE - 1] = static_cast<char>(block.rotation);
+        buffer.insert(buffer.end(), data, data + RECORD_SIZE);
+    }
+    wake.notify_one();
+}
+
+size_t EditJournal::size() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return bytesWritten + buffer.size();
+}
+
+void EditJournal::syncLoop() {
+    std::vector<char> batch;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this]() { return !running || !buffer.empty(); });
+            if (buffer.empty() && !running) break;
+
+            // give edits a moment to pile up so one fsync covers them all
+            wake.wait_for(lock, std::chrono::milliseconds(JOURNAL_SYNC_INTERVAL_MS), [this]() { return !running; });
+        }
+
+        std::lock_guard<std::mutex> fileLock(fileMutex);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            batch.swap(buffer);
+        }
+        if (batch.empty() || !file) {
+            batch.clear();
+            continue;
+        }
+
+        if (std::fwrite(batch.data(), 1, batch.size(), file) != batch.size()) {
+            std::cerr << "Error writing edit journal " << path << std::endl;
+        }
+        syncFile(file);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            bytesWritten += batch.size();
+        }
+        batch.clear();
+    }
+}
+
+void EditJournal::checkpoint() {
+    std::lock_guard<std::mutex> fileLock(fileMutex);
+    std::lock_guard<std::mutex> lock(mutex);
+
+    buffer.clear();
+    sequence = 0;
+    bytesWritten = 0;
+    if (openFile("wb")) {
+        syncFile(file);
+    }
+
+    std::remove(rotatedPath.c_str());
+    rotated = false;
+}
+
+// sequence numbers carry on across the rotation, replay reads the rotated log and then the current one as one
+bool EditJournal::rotate() {
+    std::lock_guard<std::mutex> fileLock(fileMutex);
+    if (rotated || !file) return false;
+
+    std::vector<char> batch;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        batch.swap(buffer);
+        bytesWritten += batch.size();
+    }
+
+    // usually no fsync here (it runs on the main thread), these are the last few records and the sync interval allows losing them
+    // a failed write keeps the current log as it is, the autosave is skipped
+    bool written = std::fwrite(batch.data(), 1, batch.size(), file) == batch.size();
+    written = std::fclose(file) == 0 && written;
+    file = nullptr;
+    if (!written) {
+        std::cerr << "Error writing edit journal " << path << ", not rotating it" << std::endl;
+        openFile("ab");
+        return false;
+    }
+
+    if (std::FILE* previous = std::fopen(rotatedPath.c_str(), "rb")) {
+        std::fclose(previous);
+
+        // the last autosave failed and left its rotated log, these edits go after it
+        // only after a failed save, so this one reads, appends and fsyncs the whole log on the calling thread
+        std::ifstream input(path, std::ios::in | std::ios::binary);
+        std::vector<char> contents((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+        bool read = !input.bad();
+        input.close();
+
+        std::error_code error;
+        uintmax_t previousSize = std::filesystem::file_size(rotatedPath, error);
+
+        previous = read && !error ? std::fopen(rotatedPath.c_str(), "ab") : nullptr;
+        if (!previous) {
+            std::cerr << "Error: Could not open rotated edit journal " << rotatedPath << std::endl;
+            openFile("ab");
+            return false;
+        }
+
+        bool appended = std::fwrite(contents.data(), 1, contents.size(), previous) == contents.size();
+        appended = syncFile(previous) && appended;
+        appended = std::fclose(previous) == 0 && appended;
+        if (!appended) {
+            // a cut off copy would break the sequence replay follows from the rotated log into the current one
+            std::cerr << "Error appending to rotated edit journal " << rotatedPath << ", not rotating" << std::endl;
+            std::filesystem::resize_file(rotatedPath, previousSize, error);
+            openFile("ab");
+            return false;
+        }
+    } else if (std::rename(path.c_str(), rotatedPath.c_str()) != 0) {
+        std::cerr << "Error: Could not rotate edit journal " << path << std::endl;
+        openFile("ab");
+        return false;
+    }
+
+    rotated = openFile("wb");
+
+    std::lock_guard<std::mutex> lock(mutex);
+    bytesWritten = 0;
+    return rotated;
+}
+
+void EditJournal::finishRotation(bool saved) {
+    std::lock_guard<std::mutex> fileLock(fileMutex);
+    if (saved) {
+        std::remove(rotatedPath.c_str());
+    }
+    rotated = false;
+}
+
+int EditJournal::replay(RegionStorage& storage) {
+    // a rotated log is left by an autosave that didn't finish, its edits come before the current ones
+    std::vector<char> contents;
+    {
+        std::lock_guard<std::mutex> fileLock(fileMutex);
+
+        for (const std::string& logPath : {rotatedPath, path}) {
+            std::ifstream input(logPath, std::ios::in | std::ios::binary | std::ios::ate);
+            if (!input.is_open()) continue;
+
+            size_t fileSize = static_cast<size_t>(input.tellg());
+            input.seekg(0, std::ios::beg);
+            size_t offset = contents.size();
+            contents.resize(offset + fileSize);
+            input.read(contents.data() + offset, fileSize);
+        }
+    }
+
+    // edits grouped by chunk, in the order they happened
+    struct ChunkEdit {
+        int index;
+        BlockData block;
+    };
+    std::unordered_map<uint64_t, std::vector<ChunkEdit>> chunkEdits;
+
+    // the sequence carries on across rotations, so it starts wherever the oldest log does
+    int replayed = 0;
+    uint32_t expected = 1;
+    if (contents.size() >= RECORD_SIZE) {
+        std::memcpy(&expected, contents.data(), sizeof(expected));
+    }
+    for (size_t offset = 0; offset + RECORD_SIZE <= contents.size(); offset += RECORD_SIZE, expected++) {
+        const char* data = contents.data() + offset;
+
+        // a record cut off by a crash (or garbage after it) breaks the sequence
+        uint32_t recordSequence;
+        std::memcpy(&recordSequence, data, sizeof(recordSequence));
+        if (recordSequence != expected) break;
+
+        int32_t position[3];
+        std::memcpy(position, data + sizeof(recordSequence), sizeof(position));
+
+        BlockData block;
+        block.id = static_cast<uint8_t>(data[RECORD_SIZE - 2]);
+        block.rotation = static_cast<uint8_t>(data[RECORD_SIZE - 1]);
+
+        int cx = floorDiv(position[0], CHUNK_SIZE);
+        int cy = floorDiv(position[1], CHUNK_SIZE);
+        int cz = floorDiv(position[2], CHUNK_SIZE);
+        int index = linearBlockIndex(position[0] - cx * CHUNK_SIZE, position[1] - cy * CHUNK_SIZE, position[2] - cz * CHUNK_SIZE);
+
+        chunkEdits[hashChunkCoords(cx, cy, cz)].push_back(ChunkEdit{index, block});
+        replayed++;
+    }
+
+    bool written = true;
+    if (replayed > 0) {
+        auto chunk = std::make_unique<Chunk>();
+        for (const auto& [hash, edits] : chunkEdits) {
+            int cx, cy, cz;
+            decodeChunkHash(hash, cx, cy, cz);
+
+            chunk->position = glm::vec3(cx, cy, cz) * float(CHUNK_SIZE);
+            chunk->modifiedBlocks.clear();
+
+            // a stored delta that can't be read would be overwritten by only the journal's edits,
+            // the region entry is left alone and the journal kept so the edits aren't lost either way
+            if (storage.readChunk(*chunk) == ReadResult::Failed) {
+                std::cerr << "Could not read chunk " << cx << " " << cy << " " << cz << ", not replaying its edits" << std::endl;
+                written = false;
+                continue;
+            }
+
+            for (const ChunkEdit& edit : edits) {
+                chunk->modifiedBlocks.set(edit.index, edit.block);
+            }
+            written = storage.writeChunk(*chunk) && written;
+        }
+        written = storage.sync() && written;
+
+        std::cout << "Replayed " << replayed << " block edits from " << path << std::endl;
+    }
+
+    // the journal is the only copy of edits that didn't make it into region storage
+    if (written) {
+        checkpoint();
+        return replayed;
+    }
+
+    std::cerr << "Could not write every replayed edit, keeping " << path << std::endl;
+
+    // new edits go after the valid records and carry on their sequence, whatever a crash left after them is dropped
+    std::lock_guard<std::mutex> fileLock(fileMutex);
+    std::lock_guard<std::mutex> lock(mutex);
+    sequence = expected - 1;
+    bytesWritten = replayed * RECORD_SIZE;
+    if (openFile("wb")) {
+        std::fwrite(contents.data(), 1, bytesWritten, file);
+        syncFile(file);
+        std::remove(rotatedPath.c_str());
+    }
+    return replayed;
+}
\ No newline at end of file
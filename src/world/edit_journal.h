@@ -0,0 +1,60 @@
+#pragma once
+#include "./block.h"
+#include "./region_storage.h"
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+static constexpr int JOURNAL_SYNC_INTERVAL_MS = 100;              // edits are batched this long before an fsync
+static constexpr size_t JOURNAL_CHECKPOINT_BYTES = 1024 * 1024;   // journal size that triggers a save of the world
+
+// append-only log of block edits so a crash loses at most the last sync interval
+// record: uint32 sequence, int32 world x, y, z, id, rotation (18 bytes)
+// saving the world writes the edits into region storage (checkpoint) and empties the log
+// an autosave rotates the log to <path>.old instead, new edits go to a fresh log while the old one's edits are written
+class EditJournal {
+public:
+    EditJournal(const std::string& path);
+    ~EditJournal();
+
+    // block is what the position holds after the edit
+    void record(int x, int y, int z, const BlockData& block);
+
+    // applies edits left over from a session that didn't save, returns how many
+    int replay(RegionStorage& storage);
+
+    // everything recorded so far is in region storage now
+    void checkpoint();
+
+    // moves what's recorded so far to the rotated log, false if the last rotation is still waiting for its save
+    // or the log couldn't be moved (then it's kept as it is)
+    bool rotate();
+
+    // the save of the rotated edits finished, they're dropped if it succeeded and kept for the next one if not
+    void finishRotation(bool saved);
+
+    // bytes in the current log, the rotated one doesn't count
+    size_t size();
+
+private:
+    void syncLoop();
+    bool openFile(const char* mode);
+
+    std::string path;
+    std::string rotatedPath;
+    bool rotated = false; // a rotation is waiting for finishRotation, under fileMutex
+    std::FILE* file = nullptr;
+    std::mutex fileMutex; // held while a batch is written, checkpoint waits for it
+
+    std::vector<char> buffer; // records not written yet
+    uint32_t sequence = 0;
+    size_t bytesWritten = 0;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool running = true;
+
+    std::thread thread;
+};
\ No newline at end of file
@@ -0,0 +1,137 @@
+#include "epoch_manager.h"
+#include <algorithm>
+#include <iostream>
+#include <thread>
+
+// the reader slot and guard depth of this thread
+struct ThreadEpoch {
+    EpochManager* epochs = nullptr;
+    void* reader = nullptr;
+    int depth = 0;
+};
+static thread_local ThreadEpoch threadEpoch;
+
+EpochManager::EpochManager() {
+
+}
+
+EpochManager::~EpochManager() {
+    // every reader thread is gone by now
+    std::lock_guard<std::mutex> lock(retiredMutex);
+    retired.clear();
+}
+
+// slots are taken once per thread and kept, the game only has a fixed set of reader threads
+EpochManager::Reader* EpochManager::threadReader() {
+    if (threadEpoch.epochs == this) return static_cast<Reader*>(threadEpoch.reader);
+
+    int index = readerCount.fetch_add(1);
+    Reader* reader = nullptr;
+    if (index < EPOCH_MAX_READERS) {
+        reader = &readers[index];
+    } else {
+        std::cerr << "More than " << EPOCH_MAX_READERS << " chunk reader threads, chunks get freed less often" << std::endl;
+    }
+
+    threadEpoch.epochs = this;
+    threadEpoch.reader = reader;
+    threadEpoch.depth = 0;
+    return reader;
+}
+
+void EpochManager::retire(std::shared_ptr<Chunk> chunk) {
+    if (!chunk) return;
+
+    // after the chunk left the grid, a reader entering later than this epoch can't find it anymore
+    // the fence keeps the load from being done before the grid store is visible (store -> load can reorder even on x86),
+    // it pairs with the fence in EpochGuard: a reader that can still find the chunk entered at this epoch or before
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    uint64_t epoch = globalEpoch.load();
+
+    std::lock_guard<std::mutex> lock(retiredMutex);
+    retired.emplace_back(epoch, std::move(chunk));
+}
+
+void EpochManager::collect() {
+    {
+        std::lock_guard<std::mutex> lock(retiredMutex);
+        if (retired.empty()) return;
+    }
+
+    // readers entering from now on get a newer epoch than anything retired so far
+    // chunks retired after the bump can be tagged with the new epoch, they wait for the next collect
+    // (a reader entering meanwhile may not show up in the scan below but could still find them)
+    uint64_t oldest = globalEpoch.fetch_add(1) + 1;
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if (overflowReaders.load() > 0) return;
+
+    int count = std::min(readerCount.load(), EPOCH_MAX_READERS);
+    for (int i = 0; i < count; i++) {
+        uint64_t epoch = readers[i].epoch.load();
+        if (epoch != 0) oldest = std::min(oldest, epoch);
+    }
+
+    // retired before the oldest reader came in, nobody can hold them
+    std::vector<std::shared_ptr<Chunk>> released;
+    {
+        std::lock_guard<std::mutex> lock(retiredMutex);
+        auto it = std::partition(retired.begin(), retired.end(), [oldest](const auto& entry) { return entry.first >= oldest; });
+        for (auto freed = it; freed != retired.end(); ++freed) {
+            released.push_back(std::move(freed->second));
+        }
+        retired.erase(it, retired.end());
+    }
+    // chunk pool deleters run here, outside the lock
+}
+
+void EpochManager::synchronize() {
+    // same handshake as retire(): a reader that entered without seeing the caller's stores shows up in the scan
+    uint64_t epoch = globalEpoch.fetch_add(1) + 1;
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    // the calling thread may be inside a guard itself (the main thread holds one all frame)
+    bool ownThread = threadEpoch.epochs == this && threadEpoch.depth > 0;
+    Reader* own = ownThread ? static_cast<Reader*>(threadEpoch.reader) : nullptr;
+
+    int count = std::min(readerCount.load(), EPOCH_MAX_READERS);
+    for (int i = 0; i < count; i++) {
+        if (&readers[i] == own) continue;
+        // 0 - left, newer - entered after the bump
+        for (uint64_t entered = readers[i].epoch.load(); entered != 0 && entered < epoch; entered = readers[i].epoch.load()) {
+            std::this_thread::yield();
+        }
+    }
+
+    int ownOverflow = ownThread && !own ? 1 : 0;
+    while (overflowReaders.load() > ownOverflow) {
+        std::this_thread::yield();
+    }
+}
+
+size_t EpochManager::retiredCount() {
+    std::lock_guard<std::mutex> lock(retiredMutex);
+    return retired.size();
+}
+
+EpochGuard::EpochGuard(EpochManager& epochs) : epochs(epochs), reader(epochs.threadReader()), outermost(threadEpoch.depth++ == 0) {
+    if (!outermost) return;
+
+    if (reader) {
+        reader->epoch.store(epochs.globalEpoch.load());
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    } else {
+        epochs.overflowReaders.fetch_add(1);
+    }
+}
+
+EpochGuard::~EpochGuard() {
+    threadEpoch.depth--;
+    if (!outermost) return;
+
+    if (reader) {
+        reader->epoch.store(0, std::memory_order_release);
+    } else {
+        epochs.overflowReaders.fetch_sub(1);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,65 @@
+#pragma once
+#include "./chunk.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// threads that read chunks through raw pointers (at most this many, more still works but delays freeing)
+static constexpr int EPOCH_MAX_READERS = 256;
+
+// epoch based reclamation for unloaded chunks
+// readers hold an EpochGuard while they use Chunk* from the chunk grid, entering is one store to the thread's own slot
+// an unloaded chunk is retired with the epoch it was removed in and goes back to the pool (its shared_ptr is dropped)
+// in collect(), once every reader that was inside back then has left
+class EpochManager {
+public:
+    EpochManager();
+    ~EpochManager();
+
+    // chunk is already out of the chunk grid
+    void retire(std::shared_ptr<Chunk> chunk);
+
+    // frees what no reader can still see, any thread, cheap when nothing is retired
+    void collect();
+
+    // waits until every other thread inside a guard entered after this call, the caller's own guard doesn't count
+    // stores made before it are seen by any reader still holding or taking a guard afterwards
+    void synchronize();
+
+    size_t retiredCount();
+
+private:
+    friend class EpochGuard;
+
+    // own cache line each, readers never write to a line another thread writes
+    struct alignas(64) Reader {
+        std::atomic<uint64_t> epoch{0}; // 0 - outside
+    };
+
+    Reader* threadReader();
+
+    std::atomic<uint64_t> globalEpoch{1};
+    Reader readers[EPOCH_MAX_READERS];
+    std::atomic<int> readerCount{0};
+    std::atomic<int> overflowReaders{0}; // inside without a slot of their own, nothing gets freed meanwhile
+
+    std::vector<std::pair<uint64_t, std::shared_ptr<Chunk>>> retired;
+    std::mutex retiredMutex;
+};
+
+// chunk pointers from the grid stay valid until the guard goes away, guards nest
+class EpochGuard {
+public:
+    explicit EpochGuard(EpochManager& epochs);
+    ~EpochGuard();
+
+    EpochGuard(const EpochGuard&) = delete;
+    EpochGuard& operator=(const EpochGuard&) = delete;
+
+private:
+    EpochManager& epochs;
+    EpochManager::Reader* reader;
+    bool outermost;
+};
\ No newline at end of file
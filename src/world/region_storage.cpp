@@ -0,0 +1,546 @@
+#include "region_storage.h"
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+static int floorDiv(int value, int divisor) {
+    int result = value / divisor;
+    if (value % divisor != 0 && value < 0) --result;
+    return result;
+}
+
+static void chunkCoords(const Chunk& chunk, int& x, int& y, int& z) {
+    x = static_cast<int>(std::floor(chunk.position.x / CHUNK_SIZE));
+    y = static_cast<int>(std::floor(chunk.position.y / CHUNK_SIZE));
+    z = static_cast<int>(std::floor(chunk.position.z / CHUNK_SIZE));
+}
+
+// fsync through a second handle, fstream doesn't expose its own
+static bool syncPath(const std::string& path, bool directory) {
+#ifdef _WIN32
+    if (directory) return true; // can't open a directory this way, NTFS journals the metadata anyway
+    int fd = _open(path.c_str(), _O_RDWR | _O_BINARY);
+    if (fd < 0) return false;
+    bool synced = _commit(fd) == 0;
+    _close(fd);
+#else
+    int fd = open(path.c_str(), directory ? O_RDONLY : O_RDWR);
+    if (fd < 0) return false;
+    bool synced = fsync(fd) == 0;
+    close(fd);
+#endif
+    return synced;
+}
+
+uint64_t RegionStorage::regionKey(int chunkX, int chunkY, int chunkZ) {
+    return hashChunkCoords(floorDiv(chunkX, REGION_SIZE), floorDiv(chunkY, REGION_SIZE), floorDiv(chunkZ, REGION_SIZE));
+}
+
+static int regionIndex(int chunkX, int chunkY, int chunkZ) {
+    int x = chunkX - floorDiv(chunkX, REGION_SIZE) * REGION_SIZE;
+    int y = chunkY - floorDiv(chunkY, REGION_SIZE) * REGION_SIZE;
+    int z = chunkZ - floorDiv(chunkZ, REGION_SIZE) * REGION_SIZE;
+    return x + y * REGION_SIZE + z * REGION_SIZE * REGION_SIZE;
+}
+
+RegionStorage::RegionStorage(const std::string& folder, const std::string& extension, uint32_t version) : folder(folder), extension(extension), version(version) {
+    try {
+        std::filesystem::create_directories(folder);
+    } catch (const std::exception& e) {
+        std::cerr << "Error creating directory: " << e.what() << std::endl;
+    }
+}
+
+// opens (or creates) the region holding the chunk, nullptr if the file can't be used
+// closes the least recently used region nobody is using when too many are open
+// the file is opened and read outside the global lock, the region is published locked so other threads
+// asking for it wait on its own lock instead of opening it a second time
+RegionStorage::RegionFile* RegionStorage::acquireRegion(int chunkX, int chunkY, int chunkZ) {
+    RegionFile* result = nullptr;
+    bool opening = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        uint64_t key = regionKey(chunkX, chunkY, chunkZ);
+        auto it = regions.find(key);
+        if (it != regions.end()) {
+            result = it->second.get();
+        } else {
+            // closing writes out what the old region still buffers, so it stays under the lock,
+            // a new region for the same file can't be opened before that's done
+            if (regions.size() >= REGION_MAX_OPEN) {
+                auto oldest = regions.end();
+                for (auto candidate = regions.begin(); candidate != regions.end(); ++candidate) {
+                    if (candidate->second->users > 0) continue;
+                    if (oldest == regions.end() || candidate->second->lastUse < oldest->second->lastUse) oldest = candidate;
+                }
+                if (oldest != regions.end()) {
+                    regions.erase(oldest); // fstream flushes and closes
+                }
+            }
+
+            auto region = std::make_unique<RegionFile>();
+            region->key = key;
+            region->mutex.lock();
+            opening = true;
+
+            result = region.get();
+            regions[key] = std::move(region);
+        }
+
+        result->lastUse = ++useCounter;
+        result->users++;
+    }
+
+    if (opening) {
+        int rx = floorDiv(chunkX, REGION_SIZE);
+        int ry = floorDiv(chunkY, REGION_SIZE);
+        int rz = floorDiv(chunkZ, REGION_SIZE);
+
+        std::string path = folder + "/r." + std::to_string(rx) + "." + std::to_string(ry) + "." + std::to_string(rz) + extension;
+        result->failed = !openRegion(*result, path);
+    } else {
+        result->mutex.lock();
+    }
+
+    if (result->failed) {
+        releaseRegion(result);
+        return nullptr;
+    }
+    return result;
+}
+
+void RegionStorage::releaseRegion(RegionFile* region) {
+    region->mutex.unlock();
+
+    std::unique_ptr<RegionFile> closed; // destroyed after the lock
+    std::lock_guard<std::mutex> lock(mutex);
+    region->users--;
+
+    if (region->failed && region->users == 0) {
+        auto it = regions.find(region->key);
+        if (it != regions.end() && it->second.get() == region) {
+            closed = std::move(it->second);
+            regions.erase(it);
+        }
+    }
+}
+
+bool RegionStorage::openRegion(RegionFile& region, const std::string& path) {
+    region.path = path;
+    region.file.open(path, std::ios::in | std::ios::out | std::ios::binary);
+    bool loaded = false;
+
+    if (region.file.is_open()) {
+        // one open, one read for the whole region
+        region.file.seekg(0, std::ios::end);
+        size_t size = static_cast<size_t>(region.file.tellg());
+        region.file.seekg(0, std::ios::beg);
+
+        region.contents.resize(size);
+        region.file.read(region.contents.data(), size);
+
+        uint32_t magic = 0;
+        uint32_t fileVersion = 0;
+        if (size >= REGION_HEADER_SECTORS * REGION_SECTOR_SIZE) {
+            std::memcpy(&magic, region.contents.data(), sizeof(magic));
+            std::memcpy(&fileVersion, region.contents.data() + REGION_VERSION_OFFSET, sizeof(fileVersion));
+        }
+
+        if (!region.file || magic != REGION_MAGIC) {
+            std::cerr << "Region file is corrupted: " << path << std::endl;
+            return false;
+        }
+
+        if (fileVersion == version) {
+            std::memcpy(region.entries, region.contents.data() + sizeof(uint32_t), sizeof(region.entries));
+            loaded = true;
+        } else {
+            std::cout << "Region file has version " << fileVersion << " instead of " << version << ", starting over: " << path << std::endl;
+            region.file.close();
+        }
+    }
+
+    if (!loaded) {
+        region.file.clear();
+        region.file.open(path, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!region.file.is_open()) {
+            std::cerr << "Error: Could not create region file " << path << std::endl;
+            return false;
+        }
+
+        region.contents.assign(REGION_HEADER_SECTORS * REGION_SECTOR_SIZE, 0);
+        std::memcpy(region.contents.data(), &REGION_MAGIC, sizeof(REGION_MAGIC));
+        std::memcpy(region.contents.data() + REGION_VERSION_OFFSET, &version, sizeof(version));
+        region.file.write(region.contents.data(), region.contents.size());
+    }
+
+    region.usedSectors.assign(region.contents.size() / REGION_SECTOR_SIZE, false);
+    for (int i = 0; i < REGION_HEADER_SECTORS; i++) {
+        region.usedSectors[i] = true;
+    }
+
+    for (const RegionEntry& entry : region.entries) {
+        for (uint32_t i = 0; i < entry.sectorCount; i++) {
+            if (entry.sector + i < region.usedSectors.size()) {
+                region.usedSectors[entry.sector + i] = true;
+            }
+        }
+    }
+
+    return true;
+}
+
+// writes to the file and the in memory copy, grows both when writing past the end
+void RegionStorage::writeAt(RegionFile& region, size_t offset, const char* data, size_t size) {
+    if (offset + size > region.contents.size()) {
+        region.contents.resize(offset + size, 0);
+    }
+    std::memcpy(region.contents.data() + offset, data, size);
+
+    region.file.seekp(offset);
+    region.file.write(data, size);
+}
+
+// a region file that can't be opened counts as Failed, it may well hold the chunk
+ReadResult RegionStorage::readPayload(int chunkX, int chunkY, int chunkZ, std::vector<char>& payload) {
+    RegionFile* region = acquireRegion(chunkX, chunkY, chunkZ);
+    if (!region) return ReadResult::Failed;
+
+    ReadResult result = readPayloadData(*region, chunkX, chunkY, chunkZ, payload);
+    releaseRegion(region);
+    return result;
+}
+
+bool RegionStorage::writePayload(int chunkX, int chunkY, int chunkZ, const std::vector<char>& payload) {
+    RegionFile* region = acquireRegion(chunkX, chunkY, chunkZ);
+    if (!region) return false;
+
+    bool written = writePayloadData(*region, chunkX, chunkY, chunkZ, payload);
+    releaseRegion(region);
+    return written;
+}
+
+ReadResult RegionStorage::readPayloadData(RegionFile& region, int chunkX, int chunkY, int chunkZ, std::vector<char>& payload) {
+    const RegionEntry& entry = region.entries[regionIndex(chunkX, chunkY, chunkZ)];
+    if (entry.sectorCount == 0) return ReadResult::Missing;
+
+    size_t offset = static_cast<size_t>(entry.sector) * REGION_SECTOR_SIZE;
+    size_t end = offset + static_cast<size_t>(entry.sectorCount) * REGION_SECTOR_SIZE;
+    if (end > region.contents.size()) {
+        std::cerr << "Region entry points past the end of the file, chunk " << chunkX << " " << chunkY << " " << chunkZ << std::endl;
+        return ReadResult::Failed;
+    }
+
+    uint32_t length = 0;
+    std::memcpy(&length, region.contents.data() + offset, sizeof(length));
+    if (sizeof(length) + length > end - offset) {
+        std::cerr << "Chunk data is corrupted, chunk " << chunkX << " " << chunkY << " " << chunkZ << std::endl;
+        return ReadResult::Failed;
+    }
+
+    const char* data = region.contents.data() + offset + sizeof(length);
+    payload.assign(data, data + length);
+    return ReadResult::Found;
+}
+
+bool RegionStorage::writePayloadData(RegionFile& region, int chunkX, int chunkY, int chunkZ, const std::vector<char>& payload) {
+    uint32_t length = static_cast<uint32_t>(payload.size());
+
+    std::vector<char> data;
+    data.reserve(sizeof(length) + length);
+    data.insert(data.end(), reinterpret_cast<const char*>(&length), reinterpret_cast<const char*>(&length) + sizeof(length));
+    data.insert(data.end(), payload.begin(), payload.end());
+
+    uint32_t sectorsNeeded = (data.size() + REGION_SECTOR_SIZE - 1) / REGION_SECTOR_SIZE;
+    data.resize(sectorsNeeded * REGION_SECTOR_SIZE, 0);
+
+    int index = regionIndex(chunkX, chunkY, chunkZ);
+    RegionEntry& entry = region.entries[index];
+
+    for (uint32_t i = 0; i < entry.sectorCount; i++) {
+        region.usedSectors[entry.sector + i] = false;
+    }
+
+    // same place if it still fits, otherwise the first free run big enough (or the end of the file)
+    uint32_t sector = 0;
+    if (entry.sectorCount >= sectorsNeeded) {
+        sector = entry.sector;
+    } else {
+        uint32_t run = 0;
+        for (uint32_t i = REGION_HEADER_SECTORS; i < region.usedSectors.size(); i++) {
+            run = region.usedSectors[i] ? 0 : run + 1;
+            if (run == sectorsNeeded) {
+                sector = i + 1 - run;
+                break;
+            }
+        }
+
+        if (sector == 0) {
+            sector = region.usedSectors.size();
+        }
+    }
+
+    if (sector + sectorsNeeded > region.usedSectors.size()) {
+        region.usedSectors.resize(sector + sectorsNeeded, false);
+    }
+    for (uint32_t i = 0; i < sectorsNeeded; i++) {
+        region.usedSectors[sector + i] = true;
+    }
+
+    writeAt(region, static_cast<size_t>(sector) * REGION_SECTOR_SIZE, data.data(), data.size());
+
+    entry.sector = sector;
+    entry.sectorCount = sectorsNeeded;
+    writeAt(region, sizeof(uint32_t) + index * sizeof(RegionEntry), reinterpret_cast<const char*>(&entry), sizeof(entry));
+
+    if (!region.file) {
+        std::cerr << "Error writing region file for chunk " << chunkX << " " << chunkY << " " << chunkZ << std::endl;
+        region.file.clear();
+        return false;
+    }
+    return true;
+}
+
+ReadResult RegionStorage::readChunk(Chunk& chunk) {
+    int cx, cy, cz;
+    chunkCoords(chunk, cx, cy, cz);
+
+    std::vector<char> payload;
+    ReadResult result = readPayload(cx, cy, cz, payload);
+    if (result != ReadResult::Found) return result;
+
+    uint32_t tag = 0;
+    if (payload.size() >= sizeof(tag)) {
+        std::memcpy(&tag, payload.data(), sizeof(tag));
+    }
+
+    BlockDelta modifiedBlocks;
+    bool ok = false;
+    if (tag == DELTA_FORMAT_TAG) {
+        ok = modifiedBlocks.decode(payload.data() + sizeof(tag), payload.size() - sizeof(tag));
+    } else {
+        ok = decodeLegacyDelta(payload, modifiedBlocks);
+    }
+
+    if (!ok) {
+        std::cerr << "Chunk data is corrupted, chunk " << cx << " " << cy << " " << cz << std::endl;
+        return ReadResult::Failed;
+    }
+
+    chunk.modifiedBlocks = std::move(modifiedBlocks);
+    chunk.modifiedBlocks.applyTo(chunk.blocks);
+    return ReadResult::Found;
+}
+
+// uint32 count | (uint64 hashChunkCoords(x, y, z), id, rotation) per block, rewritten in the new format on the next save
+bool RegionStorage::decodeLegacyDelta(const std::vector<char>& payload, BlockDelta& modifiedBlocks) {
+    const size_t entrySize = sizeof(uint64_t) + 2;
+    uint32_t numBlocks = 0;
+    if (payload.size() >= sizeof(numBlocks)) {
+        std::memcpy(&numBlocks, payload.data(), sizeof(numBlocks));
+    }
+
+    if (payload.size() < sizeof(numBlocks) || numBlocks > CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE || payload.size() != sizeof(numBlocks) + numBlocks * entrySize) {
+        return false;
+    }
+
+    const char* data = payload.data() + sizeof(numBlocks);
+    for (uint32_t i = 0; i < numBlocks; i++, data += entrySize) {
+        uint64_t key;
+        BlockData blockData;
+        std::memcpy(&key, data, sizeof(key));
+        blockData.id = static_cast<uint8_t>(data[8]);
+        blockData.rotation = static_cast<uint8_t>(data[9]);
+        addLegacyBlock(modifiedBlocks, key, blockData);
+    }
+
+    return true;
+}
+
+void RegionStorage::addLegacyBlock(BlockDelta& modifiedBlocks, uint64_t key, const BlockData& blockData) {
+    int x, y, z;
+    decodeChunkHash(key, x, y, z);
+
+    // Validate coordinates inside chunk bounds
+    if (x < 0 || x >= CHUNK_SIZE || y < 0 || y >= CHUNK_SIZE || z < 0 || z >= CHUNK_SIZE) {
+        std::cerr << "Block coordinates out of bounds: " << key << std::endl;
+        return;
+    }
+
+    modifiedBlocks.set(linearBlockIndex(x, y, z), blockData);
+}
+
+bool RegionStorage::writeChunk(const Chunk& chunk) {
+    if (chunk.modifiedBlocks.empty()) return true;
+
+    int cx, cy, cz;
+    chunkCoords(chunk, cx, cy, cz);
+    return writeChunkData(cx, cy, cz, chunk.modifiedBlocks);
+}
+
+bool RegionStorage::writeChunk(int chunkX, int chunkY, int chunkZ, const BlockDelta& modifiedBlocks) {
+    if (modifiedBlocks.empty()) return true;
+
+    return writeChunkData(chunkX, chunkY, chunkZ, modifiedBlocks);
+}
+
+bool RegionStorage::writeChunkData(int chunkX, int chunkY, int chunkZ, const BlockDelta& modifiedBlocks) {
+    // uint32 DELTA_FORMAT_TAG | run length encoded delta
+    std::vector<char> payload;
+    payload.insert(payload.end(), reinterpret_cast<const char*>(&DELTA_FORMAT_TAG), reinterpret_cast<const char*>(&DELTA_FORMAT_TAG) + sizeof(DELTA_FORMAT_TAG));
+    modifiedBlocks.encode(payload);
+
+    return writePayload(chunkX, chunkY, chunkZ, payload);
+}
+
+// runs on every open region with its lock held, the regions can't be closed meanwhile
+void RegionStorage::forEachOpenRegion(const std::function<void(RegionFile&)>& function) {
+    std::vector<RegionFile*> openRegions;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto& [key, region] : regions) {
+            region->users++;
+            openRegions.push_back(region.get());
+        }
+    }
+
+    for (RegionFile* region : openRegions) {
+        region->mutex.lock();
+        if (!region->failed) function(*region);
+        releaseRegion(region);
+    }
+}
+
+bool RegionStorage::flush() {
+    bool flushed = true;
+    forEachOpenRegion([&flushed](RegionFile& region) {
+        if (!region.file.flush()) {
+            std::cerr << "Error flushing region file " << region.path << std::endl;
+            region.file.clear();
+            flushed = false;
+        }
+    });
+    return flushed;
+}
+
+bool RegionStorage::sync() {
+    bool synced = true;
+    forEachOpenRegion([&synced](RegionFile& region) {
+        if (!region.file.flush() || !syncPath(region.path, false)) {
+            std::cerr << "Error syncing region file " << region.path << std::endl;
+            region.file.clear();
+            synced = false;
+        }
+    });
+
+    // new region files are only safe once their directory entry is
+    if (!syncPath(folder, true)) {
+        std::cerr << "Error syncing folder " << folder << std::endl;
+        synced = false;
+    }
+    return synced;
+}
+
+int RegionStorage::convertLegacyChunkFiles() {
+    std::vector<std::filesystem::path> legacyFiles;
+    try {
+        for (const auto& file : std::filesystem::directory_iterator(folder)) {
+            if (file.is_regular_file() && file.path().extension() == ".chunk") {
+                legacyFiles.push_back(file.path());
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error listing " << folder << ": " << e.what() << std::endl;
+        return 0;
+    }
+
+    // only deleted once their contents are synced to the region files
+    std::vector<std::filesystem::path> convertedFiles;
+    for (const auto& path : legacyFiles) {
+        // name is x_y_z from float to_string, like -1.000000_2.000000_0.000000
+        std::string name = path.stem().string();
+        size_t first = name.find('_');
+        size_t second = name.find('_', first + 1);
+        if (first == std::string::npos || second == std::string::npos) continue;
+
+        int cx, cy, cz;
+        try {
+            cx = static_cast<int>(std::floor(std::stof(name.substr(0, first))));
+            cy = static_cast<int>(std::floor(std::stof(name.substr(first + 1, second - first - 1))));
+            cz = static_cast<int>(std::floor(std::stof(name.substr(second + 1))));
+        } catch (const std::exception&) {
+            std::cerr << "Skipping chunk file with bad name: " << path << std::endl;
+            continue;
+        }
+
+        std::ifstream inputFile(path, std::ios::in | std::ios::binary);
+        if (!inputFile.is_open()) continue;
+
+        size_t numBlocks = 0;
+        inputFile.read(reinterpret_cast<char*>(&numBlocks), sizeof(numBlocks));
+        if (!inputFile || numBlocks > CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE) {
+            std::cerr << "Chunk file is corrupted: " << path << std::endl;
+            continue;
+        }
+
+        BlockDelta modifiedBlocks;
+        bool ok = true;
+        for (size_t i = 0; i < numBlocks; ++i) {
+            uint64_t key = 0;
+            BlockData data;
+            if (!inputFile.read(reinterpret_cast<char*>(&key), sizeof(key)) ||
+                !inputFile.read(reinterpret_cast<char*>(&data.id), sizeof(data.id)) ||
+                !inputFile.read(reinterpret_cast<char*>(&data.rotation), sizeof(data.rotation))) {
+                ok = false;
+                break;
+            }
+            addLegacyBlock(modifiedBlocks, key, data);
+        }
+        inputFile.close();
+
+        if (!ok) {
+            std::cerr << "Chunk file read error or corrupted: " << path << std::endl;
+            continue;
+        }
+
+        if (!modifiedBlocks.empty() && !writeChunkData(cx, cy, cz, modifiedBlocks)) {
+            std::cerr << "Error converting chunk file, keeping it: " << path << std::endl;
+            continue;
+        }
+
+        convertedFiles.push_back(path);
+    }
+
+    if (convertedFiles.empty()) return 0;
+
+    // flush + fsync first, a crash before this point still has the chunk files
+    if (!flush() || !sync()) {
+        std::cerr << "Error syncing converted chunks, keeping the chunk files" << std::endl;
+        return 0;
+    }
+
+    int converted = 0;
+    for (const auto& path : convertedFiles) {
+        std::error_code error;
+        if (!std::filesystem::remove(path, error)) {
+            std::cerr << "Error removing converted chunk file " << path << ": " << error.message() << std::endl;
+            continue;
+        }
+        converted++;
+    }
+
+    if (converted > 0) {
+        std::cout << "Converted " << converted << " chunk files to region files." << std::endl;
+    }
+    return converted;
+}
\ No newline at end of file
@@ -0,0 +1,99 @@
+#pragma once
+#include "./chunk.h"
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+static constexpr int REGION_SIZE = 16; // chunks per axis in one region file
+static constexpr int REGION_CHUNKS = REGION_SIZE * REGION_SIZE * REGION_SIZE;
+static constexpr int REGION_SECTOR_SIZE = 256;
+static constexpr uint32_t REGION_MAGIC = 0x3147524D; // "MRG1"
+static constexpr uint32_t DELTA_FORMAT_TAG = 0x31544C44; // "DLT1", older delta payloads start with a block count (at most 4096) instead
+
+// region file layout:
+// header - magic, an offset table entry (first sector, sector count) for every chunk (count 0 - not stored), format version
+// payload - starts on a sector, uint32 byte length followed by the data
+struct RegionEntry {
+    uint32_t sector = 0;
+    uint32_t sectorCount = 0;
+};
+
+static constexpr size_t REGION_VERSION_OFFSET = sizeof(uint32_t) + REGION_CHUNKS * sizeof(RegionEntry);
+static constexpr int REGION_HEADER_SECTORS = (REGION_VERSION_OFFSET + sizeof(uint32_t) + REGION_SECTOR_SIZE - 1) / REGION_SECTOR_SIZE;
+static constexpr int REGION_MAX_OPEN = 32; // region files kept open (and in memory) at once
+
+// Missing - nothing stored for the chunk, Failed - something is stored but couldn't be read or decoded
+enum class ReadResult {
+    Found,
+    Missing,
+    Failed
+};
+
+// per chunk payloads in <folder>/r.<x>.<y>.<z><extension>, 16x16x16 chunks per file
+// a region file is read whole the first time it's touched and then stays open, writes go in place
+// every region file has its own lock, so chunks in different regions can be read and written in parallel
+// the world keeps chunk deltas in here (version 0), the snapshot cache uses its own instance
+class RegionStorage {
+public:
+    // a file with a different version is thrown away and started over
+    RegionStorage(const std::string& folder, const std::string& extension = ".region", uint32_t version = 0);
+
+    // writes return false when the data didn't make it into the file (region can't be opened, write error)
+    ReadResult readPayload(int chunkX, int chunkY, int chunkZ, std::vector<char>& payload);
+    bool writePayload(int chunkX, int chunkY, int chunkZ, const std::vector<char>& payload);
+
+    // chunk deltas (modifiedBlocks), readChunk also takes the older hash keyed format
+    ReadResult readChunk(Chunk& chunk);
+    bool writeChunk(const Chunk& chunk);
+    bool writeChunk(int chunkX, int chunkY, int chunkZ, const BlockDelta& modifiedBlocks);
+
+    bool flush();
+
+    // flush + fsync of every open region file and the folder, after this the data survives a power cut
+    // false if any of it failed
+    bool sync();
+
+    // which region file the chunk goes to, chunks with the same key share one file
+    static uint64_t regionKey(int chunkX, int chunkY, int chunkZ);
+
+    // moves old one file per chunk saves (worlds/<seed>/x_y_z.chunk) into region files
+    int convertLegacyChunkFiles();
+
+private:
+    struct RegionFile {
+        std::mutex mutex; // file, entries, contents and usedSectors, held by the opener until openRegion is done
+        uint64_t key = 0;
+        std::string path;
+        std::fstream file;
+        RegionEntry entries[REGION_CHUNKS];
+        std::vector<char> contents;     // copy of the whole file
+        std::vector<bool> usedSectors;
+        uint64_t lastUse = 0;
+        int users = 0; // threads between acquireRegion and releaseRegion, the region isn't closed while > 0
+        bool failed = false; // openRegion failed, dropped from regions by its last user so the next acquire tries again
+    };
+
+    // opens (if needed) and locks the region holding the chunk, every successful call needs a releaseRegion
+    RegionFile* acquireRegion(int chunkX, int chunkY, int chunkZ);
+    void releaseRegion(RegionFile* region);
+    bool openRegion(RegionFile& region, const std::string& path);
+    ReadResult readPayloadData(RegionFile& region, int chunkX, int chunkY, int chunkZ, std::vector<char>& payload);
+    bool writePayloadData(RegionFile& region, int chunkX, int chunkY, int chunkZ, const std::vector<char>& payload);
+    bool writeChunkData(int chunkX, int chunkY, int chunkZ, const BlockDelta& modifiedBlocks);
+    static bool decodeLegacyDelta(const std::vector<char>& payload, BlockDelta& modifiedBlocks);
+    static void addLegacyBlock(BlockDelta& modifiedBlocks, uint64_t key, const BlockData& blockData);
+    void forEachOpenRegion(const std::function<void(RegionFile&)>& function);
+    void writeAt(RegionFile& region, size_t offset, const char* data, size_t size);
+
+    std::string folder;
+    std::string extension;
+    uint32_t version;
+
+    std::unordered_map<uint64_t, std::unique_ptr<RegionFile>> regions;
+    uint64_t useCounter = 0;
+    std::mutex mutex; // regions and useCounter, never held while waiting for a region lock
+};
\ No newline at end of file
@@ -1,14 +1,47 @@
 #include "world.h"
 #include <iostream>
 
+#include <cmath>
 #include <random>
 #include <unordered_set>
 
-World::World(unsigned int seed) : seed(seed), noiseGenerator(seed){
+World::World(unsigned int seed) : seed(seed), chunkPool(CHUNK_POOL_CAPACITY), chunkGrid(epochs), noiseGenerator(seed), storage("worlds/" + std::to_string(seed)), journal("worlds/" + std::to_string(seed) + "/edits.journal"), writer(storage), snapshotCache("worlds/" + std::to_string(seed) + "/cache", SNAPSHOT_CACHE_VERSION){
+    storage.convertLegacyChunkFiles();
 
+    // edits from a session that crashed before saving
+    journal.replay(storage);
 }
 
+// generated blocks come from the snapshot cache when possible, the player's edits go on top either way
 void World::generateChunk(Chunk& chunk){
+    bool cached = CHUNK_SNAPSHOT_CACHE && snapshotCache.load(chunk);
+
+    if (!cached) {
+        generateTerrain(chunk);
+
+        if (CHUNK_SNAPSHOT_CACHE) {
+            snapshotCache.store(chunk);
+        }
+    }
+
+    // a save still waiting in the writer is newer than what's on disk
+    if (!writer.readPending(chunk)) {
+        storage.readChunk(chunk);
+    }
+}
+
+// the odd generation turns away mesh jobs that start copying from now on, the wait is for the ones that didn't see it
+// blocks can reallocate their palette and words, nothing may read them while they change
+void World::beginBlockEdit(Chunk& chunk){
+    chunk.editGeneration.fetch_add(1);
+    epochs.synchronize();
+}
+
+void World::endBlockEdit(Chunk& chunk){
+    chunk.editGeneration.fetch_add(1, std::memory_order_release);
+}
+
+void World::generateTerrain(Chunk& chunk){
     uint64_t chunkSeed = uint32_t(
         int(chunk.position.x) * 73856093 ^
         int(chunk.position.y) * 19349663 ^
@@ -21,16 +54,20 @@ void World::generateChunk(Chunk& chunk){
     std::uniform_real_distribution<double> dist(0.0, 1.0);
     bool isChunkAir = true;
 
+    // generated into a plain array, packed into the chunk's palette storage once at the end
+    std::vector<BlockData> blocks(CHUNK_VOLUME);
+
+    int chunkX = static_cast<int>(std::floor(chunk.position.x / CHUNK_SIZE));
+    int chunkZ = static_cast<int>(std::floor(chunk.position.z / CHUNK_SIZE));
+    std::shared_ptr<const Column> column = columnCache.get(chunkX, chunkZ, [&](Column& newColumn) {
+        computeColumn(chunkX, chunkZ, newColumn);
+    });
+
     for (int x = 0; x < CHUNK_SIZE; ++x) {
         for (int z = 0; z < CHUNK_SIZE; ++z) {
-            double noiseHeight = noiseGenerator.noise2D(chunk.position.x + x, chunk.position.z + z, 8, 0.01);
+            int height = column->height[x + z * CHUNK_SIZE];
 
-            double noiseTemp = noiseGenerator.noise2D(chunk.position.x + x, chunk.position.z + z, 4, 0.002, 1);
-            double noiseMoist = noiseGenerator.noise2D(chunk.position.x + x, chunk.position.z + z, 4, 0.002, 2);
-            
-            int height = getHeight(noiseHeight, noiseTemp, noiseMoist);
-
-            Biome biome = getBiome(getBiomeType(noiseTemp, noiseMoist));
+            Biome biome = getBiome(column->biome[x + z * CHUNK_SIZE]);
 
             for (int y = 0; y < CHUNK_SIZE; ++y) {
                 int blockY = chunk.position.y + y;
@@ -62,26 +99,51 @@ void World::generateChunk(Chunk& chunk){
                     }
 
                     if(!noiseGenerator.caveAt(chunk.position.x + x, chunk.position.y + y, chunk.position.z + z, height)){
-                        setBlockID(chunk, x, y, z, static_cast<int>(chosenBlock));
+                        blocks[blockIndex(x, y, z)].id = static_cast<uint8_t>(chosenBlock);
                     }
                 }
             }
         }
     }
 
-    if(!isChunkAir){
+    // sky chunk, one palette entry and no index array
+    if (isChunkAir) {
+        chunk.blocks.fill(BlockData());
+        return;
+    }
+
+    {
         std::unordered_map<glm::ivec3, BlockType, ivec3_hash> oresPositions;
 
         generateOres(oresPositions, chunk, chunkSeed);
 
         for (auto& [pos, block] : oresPositions) {
-            int id = getBlockID(chunk, pos.x, pos.y, pos.z);
-            if(id != static_cast<int>(BlockType::Dark_Stone) &&  id != static_cast<int>(BlockType::Stone)) continue;
-            setBlockID(chunk, pos.x, pos.y, pos.z, static_cast<int>(block));
+            BlockData& blockData = blocks[blockIndex(pos.x, pos.y, pos.z)];
+            if(blockData.id != static_cast<int>(BlockType::Dark_Stone) &&  blockData.id != static_cast<int>(BlockType::Stone)) continue;
+            blockData.id = static_cast<uint8_t>(block);
         }
     }
 
-    readChunkFromFile(chunk, seed);
+    chunk.blocks.pack(blocks.data());
+}
+
+// the 2d noise part of generation, shared by every chunk in the column
+void World::computeColumn(int chunkX, int chunkZ, Column& column) {
+    for (int x = 0; x < CHUNK_SIZE; ++x) {
+        for (int z = 0; z < CHUNK_SIZE; ++z) {
+            double worldX = chunkX * CHUNK_SIZE + x;
+            double worldZ = chunkZ * CHUNK_SIZE + z;
+            int index = x + z * CHUNK_SIZE;
+
+            double noiseHeight = noiseGenerator.noise2D(worldX, worldZ, 8, 0.01);
+
+            column.temperature[index] = noiseGenerator.noise2D(worldX, worldZ, 4, 0.002, 1);
+            column.moisture[index] = noiseGenerator.noise2D(worldX, worldZ, 4, 0.002, 2);
+
+            column.height[index] = getHeight(noiseHeight, column.temperature[index], column.moisture[index]);
+            column.biome[index] = getBiomeType(column.temperature[index], column.moisture[index]);
+        }
+    }
 }
 
 int World::getHeight(double noiseHeight, double noiseTemp, double noiseMoist) {
@@ -6,6 +6,14 @@
 #include "./chunk.h"
 #include <memory>
 #include "./biome.h"
+#include "./region_storage.h"
+#include "./chunk_writer.h"
+#include "./chunk_cache.h"
+#include "./edit_journal.h"
+#include "./chunk_pool.h"
+#include "./epoch_manager.h"
+#include "./chunk_grid.h"
+#include "./column_cache.h"
 #include <shared_mutex>
 
 class NoiseGenerator {
@@ -77,22 +85,42 @@ struct ivec3_hash {
     }
 };
 
+// bump when generateChunk output changes, cached snapshots from other versions get thrown away
+static constexpr uint32_t WORLD_GENERATOR_VERSION = 1;
+// snapshots keep blocks in storage order, so the block layout is part of their version
+static constexpr uint32_t SNAPSHOT_CACHE_VERSION = WORLD_GENERATOR_VERSION | (BLOCK_LAYOUT == BlockLayout::Morton ? 0x80000000u : 0u);
+
 class World {
 public:
     int seed;
-    std::unordered_map<uint64_t, std::shared_ptr<Chunk>> chunkMap;
-    std::shared_mutex chunkMapMutex;
+    ChunkPool chunkPool; // before chunkGrid, chunks go back to the pool when they're destroyed
+    EpochManager epochs; // unloaded chunks wait here until no thread can still read them
+    ChunkGrid chunkGrid;
+    std::shared_mutex chunkGridMutex; // exclusive to add/remove chunks or edit blocks, shared to iterate or to read blocks off the main thread
 
     std::unordered_set<uint64_t> loadedChunks;
     std::shared_mutex loadedChunksMutex;
 
     NoiseGenerator noiseGenerator;
+    RegionStorage storage; // modified blocks of every chunk on disk
+    EditJournal journal;   // every block edit, until the next save of the world (before writer, autosaves finish on its thread)
+    ChunkWriter writer;    // all saves go through here, never call storage.writeChunk while holding a world lock
+    ChunkSnapshotCache snapshotCache;
+    ColumnCache columnCache; // heights and climate of columns in range, evicted together with the chunks
 
     World(unsigned int seed);
 
     void generateChunk(Chunk& chunk);
+
+    // block edits of a chunk in the grid go between these, with chunkGridMutex held exclusive
+    // mesh jobs copy chunks under an EpochGuard only, begin waits out the ones already copying
+    void beginBlockEdit(Chunk& chunk);
+    void endBlockEdit(Chunk& chunk);
+
     int getHeight(double noiseHeight, double noiseTemp, double noiseMoist);
 
 private:
+    void generateTerrain(Chunk& chunk);
+    void computeColumn(int chunkX, int chunkZ, Column& column);
     void generateOres(std::unordered_map<glm::ivec3, BlockType, ivec3_hash>& oresPositions, Chunk& chunk, uint64_t chunkSeed);
 };
\ No newline at end of file
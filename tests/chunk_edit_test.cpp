@@ -0,0 +1,117 @@
+// Chunk copy test, readers copy a chunk under an EpochGuard while another thread edits its blocks
+// usage: chunk_edit_test [seconds] [reader threads]
+//
+// the edit steps are the ones of World::beginBlockEdit / endBlockEdit: generation odd, synchronize, write, generation even
+// readers copy like a mesh job: look at the generation, unpack, look again, drop the copy when it was odd or changed
+// every edit turns all blocks into one new id, so a copy with two different ids overlapped an edit it didn't notice
+// the ids grow the palette until the indices widen and the buffers are reallocated (build with -fsanitize=address
+// to also catch reads of the freed ones)
+
+#include "chunk_grid.h"
+#include "chunk_pool.h"
+#include "epoch_manager.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+#include <vector>
+
+int main(int argc, char** argv) {
+    double seconds = argc > 1 ? std::atof(argv[1]) : 2.0;
+    int readerCount = argc > 2 ? std::atoi(argv[2]) : 4;
+
+    ChunkPool pool(4);
+    EpochManager epochs;
+    ChunkGrid grid(epochs);
+
+    uint64_t hash = hashChunkCoords(1, 1, 1);
+    grid.insert(hash, pool.acquire());
+
+    std::atomic<bool> running{true};
+    std::atomic<uint64_t> copies{0};
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<uint64_t> torn{0};
+
+    std::vector<std::thread> readers;
+    for (int i = 0; i < readerCount; i++) {
+        readers.emplace_back([&]() {
+            // CHUNK_VOLUME blocks, kept off the stack
+            auto blocks = std::make_unique<BlockData[]>(CHUNK_VOLUME);
+            uint64_t copied = 0, skipped = 0;
+
+            while (running.load(std::memory_order_relaxed)) {
+                EpochGuard epoch(epochs);
+                const Chunk* chunk = grid.find(hash);
+                if (!chunk) continue;
+
+                uint32_t generation = chunk->editGeneration.load(std::memory_order_acquire);
+                if (generation & 1) {
+                    skipped++;
+                    continue;
+                }
+
+                chunk->blocks.unpack(blocks.get());
+
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (chunk->editGeneration.load(std::memory_order_relaxed) != generation) {
+                    skipped++;
+                    continue;
+                }
+
+                for (int index = 1; index < CHUNK_VOLUME; index++) {
+                    if (blocks[index].id != blocks[0].id) {
+                        torn.fetch_add(1);
+                        break;
+                    }
+                }
+                copied++;
+            }
+
+            copies.fetch_add(copied);
+            dropped.fetch_add(skipped);
+        });
+    }
+
+    // the game's main thread edits while holding a guard of its own for the whole frame, synchronize skips it
+    EpochGuard mainEpoch(epochs);
+    Chunk* chunk = grid.find(hash);
+
+    uint64_t edits = 0;
+    auto end = std::chrono::steady_clock::now() + std::chrono::duration<double>(seconds);
+    while (std::chrono::steady_clock::now() < end) {
+        chunk->editGeneration.fetch_add(1);
+        epochs.synchronize();
+
+        // every 64 edits the palette is rebuilt to one entry, the next ones grow it (and the index width) again
+        BlockData block;
+        block.id = 1 + edits % 255;
+        if (edits % 64 == 0) {
+            std::vector<BlockData> packed(CHUNK_VOLUME, block);
+            chunk->blocks.pack(packed.data());
+        } else {
+            for (int index = 0; index < CHUNK_VOLUME; index++) {
+                chunk->blocks.set(index, block);
+            }
+        }
+
+        chunk->editGeneration.fetch_add(1, std::memory_order_release);
+        edits++;
+    }
+
+    running = false;
+    for (std::thread& reader : readers) {
+        reader.join();
+    }
+
+    std::printf("%d readers, %.1f s: %llu edits, %llu copies, %llu dropped as stale, %llu torn\n",
+        readerCount, seconds, static_cast<unsigned long long>(edits), static_cast<unsigned long long>(copies.load()),
+        static_cast<unsigned long long>(dropped.load()), static_cast<unsigned long long>(torn.load()));
+
+    if (torn.load() != 0 || copies.load() == 0) {
+        std::printf("FAILED\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,116 @@
+// Chunk reclamation stress test, readers find chunks in the grid while another thread removes, retires and collects them
+// usage: epoch_stress_test [seconds] [reader threads]
+//
+// every chunk gets a position matching its grid coords before it goes in, the pool resets it to 0 when it comes back
+// a reader that sees the position change while it still holds its EpochGuard read a chunk that was recycled under it
+// (build with -fsanitize=address to also catch chunks the pool deleted)
+
+#include "chunk_grid.h"
+#include "chunk_pool.h"
+#include "epoch_manager.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <vector>
+
+// chunk coords 1..AREA so no loaded chunk has the reset position (0, 0, 0)
+static constexpr int AREA = 4;
+
+static glm::vec3 chunkPosition(int x, int y, int z) {
+    return glm::vec3(x * CHUNK_SIZE, y * CHUNK_SIZE, z * CHUNK_SIZE);
+}
+
+int main(int argc, char** argv) {
+    double seconds = argc > 1 ? std::atof(argv[1]) : 2.0;
+    int readerCount = argc > 2 ? std::atoi(argv[2]) : 4;
+
+    // same declaration order as World, the pool outlives the chunks that go back to it
+    ChunkPool pool(64);
+    EpochManager epochs;
+    ChunkGrid grid(epochs);
+
+    std::atomic<bool> running{true};
+    std::atomic<uint64_t> reads{0};
+    std::atomic<uint64_t> recycled{0};
+
+    std::vector<std::thread> readers;
+    for (int i = 0; i < readerCount; i++) {
+        readers.emplace_back([&, i]() {
+            std::mt19937 rng(100 + i);
+            uint64_t found = 0;
+
+            while (running.load(std::memory_order_relaxed)) {
+                {
+                    EpochGuard epoch(epochs);
+                    for (int n = 0; n < 64; n++) {
+                        int x = 1 + rng() % AREA, y = 1 + rng() % 2, z = 1 + rng() % AREA;
+                        Chunk* chunk = grid.find(x, y, z);
+                        if (!chunk) continue;
+
+                        // read it a few times, it has to stay the same chunk while the guard is held
+                        // volatile so the compiler can't read it once and reuse the value
+                        glm::vec3 expected = chunkPosition(x, y, z);
+                        const volatile float* position = &chunk->position.x;
+                        for (int k = 0; k < 16; k++) {
+                            if (position[0] != expected.x || position[1] != expected.y || position[2] != expected.z) {
+                                recycled.fetch_add(1);
+                                break;
+                            }
+                        }
+                        found++;
+                    }
+                }
+
+                // readers collect too, collect() is allowed from any thread outside a guard
+                if (rng() % 16 == 0) epochs.collect();
+            }
+
+            reads.fetch_add(found);
+        });
+    }
+
+    // insert/remove are single writer, the grid lock of the game isn't needed with one writer thread
+    std::mt19937 rng(7);
+    uint64_t removes = 0;
+    auto end = std::chrono::steady_clock::now() + std::chrono::duration<double>(seconds);
+    while (std::chrono::steady_clock::now() < end) {
+        int x = 1 + rng() % AREA, y = 1 + rng() % 2, z = 1 + rng() % AREA;
+        uint64_t hash = hashChunkCoords(x, y, z);
+
+        if (grid.find(hash)) {
+            grid.remove(hash);
+            removes++;
+        } else {
+            auto chunk = pool.acquire();
+            chunk->position = chunkPosition(x, y, z);
+            grid.insert(hash, std::move(chunk));
+        }
+
+        if (rng() % 4 == 0) epochs.collect();
+    }
+
+    running = false;
+    for (std::thread& reader : readers) {
+        reader.join();
+    }
+
+    // no readers left, everything retired so far is older than the epoch collect() moves to
+    epochs.collect();
+
+    ChunkPool::Stats stats = pool.getStats();
+    size_t leftover = epochs.retiredCount();
+
+    std::printf("%d readers, %.1f s: %llu removes, %llu chunk reads, %llu recycled under a reader, %zu never freed\n",
+        readerCount, seconds, static_cast<unsigned long long>(removes), static_cast<unsigned long long>(reads.load()),
+        static_cast<unsigned long long>(recycled.load()), leftover);
+
+    bool ok = recycled.load() == 0 && leftover == 0 && stats.inUse == grid.size();
+    if (!ok) {
+        std::printf("FAILED (chunks in use %zu, in grid %zu)\n", stats.inUse, grid.size());
+        return 1;
+    }
+    return 0;
+}
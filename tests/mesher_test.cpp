@@ -0,0 +1,211 @@
+// Mesher equivalence test, the merging meshers have to cover exactly the faces the per face reference draws
+// usage: mesher_test
+//
+// every quad is rasterized back into the block faces it covers, a face also keeps the texture, uv rotation and light
+// of its quad, so a merge across different blocks or rotations shows up as a wrong face and not only a missing one
+// binary only finds faces another way than greedy and merges them the same, so it has to give the same quads too
+
+#include "mesh_system.h"
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <set>
+#include <tuple>
+#include <vector>
+
+// face, block x, y, z, atlas tile, uv rotation, light
+using CoveredFace = std::tuple<int, int, int, int, int, int, int>;
+
+// axis the face normal points along and if it's the positive side, same face order as the mesher
+static const int faceAxis[6] = { 2, 2, 0, 0, 1, 1 };
+static const bool facePositive[6] = { false, true, false, true, true, false };
+
+// false when quads overlap or a quad isn't a flat rectangle
+static bool rasterize(const ChunkMeshData& data, std::set<CoveredFace>& faces) {
+    if (data.vertices.size() % 4 != 0) return false;
+
+    for (size_t quad = 0; quad < data.vertices.size(); quad += 4) {
+        int low[3] = { 32, 32, 32 };
+        int high[3] = { 0, 0, 0 };
+        uint32_t attributes = data.vertices[quad].data >> 15;
+        uint16_t tile = data.vertices[quad].tile;
+
+        for (size_t vert = quad; vert < quad + 4; vert++) {
+            uint32_t packed = data.vertices[vert].data;
+            if (packed >> 15 != attributes || data.vertices[vert].tile != tile) return false;
+
+            int pos[3] = { int(packed & 31), int((packed >> 5) & 31), int((packed >> 10) & 31) };
+            for (int axis = 0; axis < 3; axis++) {
+                low[axis] = std::min(low[axis], pos[axis]);
+                high[axis] = std::max(high[axis], pos[axis]);
+            }
+        }
+
+        int face = attributes & 7;
+        int uvRotation = (attributes >> 3) & 1;
+        int light = attributes >> 4;
+        if (face > 5) return false;
+
+        // the quad lies on the face plane, blocks of a positive face are one below it
+        int axis = faceAxis[face];
+        if (low[axis] != high[axis]) return false;
+        low[axis] -= facePositive[face] ? 1 : 0;
+        high[axis] = low[axis] + 1;
+
+        for (int z = low[2]; z < high[2]; z++) {
+            for (int y = low[1]; y < high[1]; y++) {
+                for (int x = low[0]; x < high[0]; x++) {
+                    if (!faces.insert({ face, x, y, z, tile, uvRotation, light }).second) return false;
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+// packed vertices of every quad, sorted, quad order doesn't matter but the vertex order in a quad does
+static std::vector<std::array<uint64_t, 4>> sortedQuads(const ChunkMeshData& data) {
+    std::vector<std::array<uint64_t, 4>> quads;
+    for (size_t quad = 0; quad + 3 < data.vertices.size(); quad += 4) {
+        std::array<uint64_t, 4> vertices;
+        for (int vert = 0; vert < 4; vert++) {
+            const ChunkVertex& v = data.vertices[quad + vert];
+            vertices[vert] = static_cast<uint64_t>(v.data) << 16 | v.tile;
+        }
+        quads.push_back(vertices);
+    }
+    std::sort(quads.begin(), quads.end());
+    return quads;
+}
+
+static void setBlock(PaddedChunk& chunk, int x, int y, int z, int id, int rotation = 0) {
+    BlockData& block = chunk.blocks[getPaddedIndex(x, y, z)];
+    block.id = id;
+    block.rotation = rotation;
+}
+
+// chunks include the border, so faces toward the neighbors get culled (or not) like in the game
+
+static void makeFlat(PaddedChunk& chunk) {
+    for (int z = -1; z <= CHUNK_SIZE; z++) {
+        for (int y = -1; y < 8; y++) {
+            for (int x = -1; x <= CHUNK_SIZE; x++) {
+                setBlock(chunk, x, y, z, y == 7 ? 2 : y > 4 ? 1 : 4);
+            }
+        }
+    }
+}
+
+// two plateaus with a wall across x, the low side is open toward -x and the high side runs into the neighbor
+static void makeCliff(PaddedChunk& chunk) {
+    for (int z = -1; z <= CHUNK_SIZE; z++) {
+        for (int x = -1; x <= CHUNK_SIZE; x++) {
+            int height = x < 6 ? 3 : 12 + (z % 3 == 0 ? 1 : 0);
+            if (x == -1) height = 1;
+            for (int y = -1; y <= std::min(height, CHUNK_SIZE); y++) {
+                setBlock(chunk, x, y, z, y == height ? 2 : y > height - 3 ? 1 : 4);
+            }
+        }
+    }
+}
+
+static void makeRandom(PaddedChunk& chunk, unsigned seed) {
+    std::mt19937 rng(seed);
+    for (int z = -1; z <= CHUNK_SIZE; z++) {
+        for (int y = -1; y <= CHUNK_SIZE; y++) {
+            for (int x = -1; x <= CHUNK_SIZE; x++) {
+                if (rng() % 2) setBlock(chunk, x, y, z, 1 + rng() % 4);
+            }
+        }
+    }
+}
+
+// one block type in every rotation, logs lying along x and z next to standing ones
+static void makeMixedRotation(PaddedChunk& chunk, unsigned seed) {
+    std::mt19937 rng(seed);
+    for (int z = -1; z <= CHUNK_SIZE; z++) {
+        for (int y = -1; y <= CHUNK_SIZE; y++) {
+            for (int x = -1; x <= CHUNK_SIZE; x++) {
+                if (rng() % 8 == 0) continue;
+                setBlock(chunk, x, y, z, 17, ((x + 1) / 3 + (y + 1) / 4 + (z + 1) / 5) % 5);
+            }
+        }
+    }
+}
+
+static bool checkChunk(MeshSystem& meshSystem, const char* name, const PaddedChunk& chunk) {
+    std::set<CoveredFace> reference;
+    if (!rasterize(meshSystem.createChunkDataPerFace(chunk), reference)) {
+        std::printf("%s: per face mesh has overlapping or broken quads\n", name);
+        return false;
+    }
+
+    bool ok = true;
+    ChunkMeshData greedy = meshSystem.createChunkDataGreedy(chunk);
+    ChunkMeshData binary = meshSystem.createChunkDataBinary(chunk);
+
+    const char* modeNames[] = { "greedy", "binary" };
+    for (int mode = 0; mode < 2; mode++) {
+        const ChunkMeshData& data = mode == 0 ? greedy : binary;
+
+        std::set<CoveredFace> covered;
+        if (!rasterize(data, covered)) {
+            std::printf("%s: %s mesh has overlapping or broken quads\n", name, modeNames[mode]);
+            ok = false;
+            continue;
+        }
+
+        if (covered != reference) {
+            size_t missing = 0;
+            for (const CoveredFace& face : reference) missing += covered.count(face) == 0;
+            std::printf("%s: %s mesh covers %zu faces, %zu of the %zu per face ones are missing\n",
+                name, modeNames[mode], covered.size(), missing, reference.size());
+            ok = false;
+            continue;
+        }
+
+        std::printf("%s: %zu faces, %s %zu quads\n", name, reference.size(), modeNames[mode], data.vertices.size() / 4);
+    }
+
+    if (sortedQuads(greedy) != sortedQuads(binary)) {
+        std::printf("%s: binary quads differ from greedy ones\n", name);
+        ok = false;
+    }
+
+    return ok;
+}
+
+int main() {
+    MeshSystem meshSystem;
+    bool ok = true;
+
+    // PaddedChunk is ~12 KB, kept off the stack
+    auto chunk = std::make_unique<PaddedChunk>();
+    ok &= checkChunk(meshSystem, "empty", *chunk);
+
+    makeFlat(*chunk);
+    ok &= checkChunk(meshSystem, "flat", *chunk);
+
+    chunk = std::make_unique<PaddedChunk>();
+    makeCliff(*chunk);
+    ok &= checkChunk(meshSystem, "cliff", *chunk);
+
+    for (unsigned seed = 1; seed <= 4; seed++) {
+        chunk = std::make_unique<PaddedChunk>();
+        makeRandom(*chunk, seed);
+        ok &= checkChunk(meshSystem, "random", *chunk);
+
+        chunk = std::make_unique<PaddedChunk>();
+        makeMixedRotation(*chunk, seed);
+        ok &= checkChunk(meshSystem, "mixed rotation", *chunk);
+    }
+
+    if (!ok) {
+        std::printf("FAILED\n");
+        return 1;
+    }
+    return 0;
+}